@@ -1,13 +1,68 @@
 #include "Chat.hpp"
-#include <mutex>
+#include <set>
+#include <shared_mutex>
 
 using namespace std;
 
-ChatMessage chat(const ChatMessage& new_msg)
+namespace
 {
-    static mutex mtx;
-    lock_guard<mutex> lg{mtx};
+    // only touched exclusively when a network task starts or ends - producers share it
+    shared_mutex inboxes_mtx;
+    set<ChatInbox*> inboxes;
+} // namespace
 
-    static ChatMessage msg;
-    return exchange(msg, new_msg);
+ChatInbox::ChatInbox()
+{
+    lock_guard<shared_mutex> lg{inboxes_mtx};
+    inboxes.insert(this);
+}
+
+ChatInbox::~ChatInbox()
+{
+    {
+        lock_guard<shared_mutex> lg{inboxes_mtx};
+        inboxes.erase(this);
+    }
+    drain();
+}
+
+ChatInbox::operator FD() const
+{
+    return wakeup;
+}
+
+void ChatInbox::push(ChatMessage msg)
+{
+    auto node = new Node{move(msg), head.load(memory_order_relaxed)};
+    while (not head.compare_exchange_weak(node->next, node, memory_order_release, memory_order_relaxed))
+        ;
+
+    // the consumer clears the wakeup before draining, so only the push onto an empty inbox needs to signal it
+    if (not node->next)
+        wakeup.signal();
+}
+
+void ChatInbox::clearWakeup()
+{
+    wakeup.clear();
+}
+
+ChatMessages ChatInbox::drain()
+{
+    // the producers build a stack, so reversing it restores the order in which the messages were pushed
+    ChatMessages msgs;
+    for (auto node = head.exchange(nullptr, memory_order_acquire); node;)
+    {
+        msgs.push_back(move(node->msg));
+        delete exchange(node, node->next);
+    }
+    reverse(begin(msgs), end(msgs));
+    return msgs;
+}
+
+void chat(const ChatMessage& msg)
+{
+    shared_lock<shared_mutex> lock{inboxes_mtx};
+    for (auto inbox : inboxes)
+        inbox->push(msg);
 }
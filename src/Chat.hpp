@@ -1,5 +1,35 @@
 #pragma once
 
-#include "Typedefs.hpp"
+#include <atomic>
+#include "EventFd.hpp"
 
-ChatMessage chat(const ChatMessage& = {});
+using ChatMessages = std::vector<ChatMessage>;
+
+// Lock-free multi-producer, single-consumer queue of messages for one network task to send. Every inbox that exists
+// receives a copy of each chatted message.
+class ChatInbox
+{
+public:
+    ChatInbox();
+    ~ChatInbox();
+    ChatInbox(const ChatInbox&) = delete;
+    ChatInbox& operator=(const ChatInbox&) = delete;
+
+    operator FD() const;
+
+    void push(ChatMessage);
+    void clearWakeup();
+    ChatMessages drain();
+
+private:
+    struct Node
+    {
+        ChatMessage msg;
+        Node* next;
+    };
+
+    std::atomic<Node*> head{nullptr};
+    EventFd wakeup;
+};
+
+void chat(const ChatMessage&);
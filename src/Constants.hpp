@@ -1,4 +1,7 @@
 #pragma once
 
 constexpr auto quit_msg = "q";
+constexpr auto add_address_cmd = "+addr ";
+constexpr auto remove_address_cmd = "-addr ";
+constexpr auto pr_msg_cmd = "+pr "; // +pr <policy>:<value> <message>
 #define ignore_assoc 0
@@ -0,0 +1,83 @@
+#include "Epoll.hpp"
+#include <fstream>
+#include <string>
+#include <tools/ThreadSafeLogger.hpp>
+#include "SocketErrorChecks.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr auto max_events_per_wait = 1024;
+}
+
+Epoll::Epoll() : epoll_fd(checkedEpollCreate(epoll_create1(EPOLL_CLOEXEC)))
+{
+    events.resize(max_events_per_wait);
+    ready_fds.reserve(max_events_per_wait);
+    writable_fds.reserve(max_events_per_wait);
+}
+
+Epoll::operator FD() const
+{
+    return epoll_fd;
+}
+
+void Epoll::add(FD fd, Events events)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    checkEpollCtl(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event));
+    DEBUG_LOG << "Watching fd = " << fd << " on epoll fd = " << epoll_fd;
+}
+
+void Epoll::modify(FD fd, Events events)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    checkEpollCtl(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event));
+}
+
+void Epoll::remove(FD fd)
+{
+    constexpr auto ignored_event = nullptr;
+    checkEpollCtl(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, ignored_event));
+    DEBUG_LOG << "Stopped watching fd = " << fd << " on epoll fd = " << epoll_fd;
+}
+
+Size Epoll::watchedFdCount() const
+{
+    // the fdinfo of an epoll fd has one "tfd:" line per registered fd
+    ifstream fdinfo{"/proc/self/fdinfo/" + to_string(FD{epoll_fd})};
+    Size count{};
+    for (string line; getline(fdinfo, line);)
+        if (line.starts_with("tfd:"))
+            ++count;
+    return count;
+}
+
+FDs Epoll::wait(Timeout timeout)
+{
+    // registrations persist between waits, so the cost of a wakeup depends only on the number of ready fds
+    const auto ready_count =
+        checkedEpollWait(epoll_wait(epoll_fd, events.data(), events.size(), static_cast<int>(timeout.count())));
+    ready_fds.clear();
+    writable_fds.clear();
+    for (auto i = 0; i < ready_count; ++i)
+    {
+        const auto fd = events[i].data.fd;
+        const auto ready_events = events[i].events;
+        if (ready_events & EPOLLOUT)
+            writable_fds.push_back(fd);
+        if (ready_events & EPOLLIN or not(ready_events & EPOLLOUT))
+            ready_fds.push_back(fd);
+    }
+    return ready_fds;
+}
+
+const FDs& Epoll::writableFds() const
+{
+    return writable_fds;
+}
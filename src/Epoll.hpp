@@ -0,0 +1,28 @@
+#pragma once
+
+#include <sys/epoll.h>
+#include "FileDescriptor.hpp"
+
+class Epoll
+{
+public:
+    using Timeout = std::chrono::milliseconds;
+    using Events = u32;
+
+    Epoll();
+
+    operator FD() const;
+
+    void add(FD, Events = EPOLLIN);
+    void modify(FD, Events);
+    void remove(FD);
+    FDs wait(Timeout = Timeout{100}); // readable fds, or ones with nothing but an error or hangup to report
+    const FDs& writableFds() const;   // those of the last wait that were watched for EPOLLOUT and are writable
+    Size watchedFdCount() const;      // as registered in the kernel, not as remembered here
+
+private:
+    FileDescriptor epoll_fd;
+    std::vector<epoll_event> events;
+    FDs ready_fds;
+    FDs writable_fds;
+};
@@ -0,0 +1,28 @@
+#include "EventFd.hpp"
+#include <sys/eventfd.h>
+#include "SocketErrorChecks.hpp"
+
+namespace
+{
+    using Counter = eventfd_t;
+    constexpr auto initial_value = 0;
+} // namespace
+
+EventFd::EventFd() : fd(checkedEventfd(eventfd(initial_value, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+EventFd::operator FD() const
+{
+    return fd;
+}
+
+void EventFd::signal()
+{
+    const Counter one = 1;
+    checkWrite(write(fd, &one, sizeof(one)));
+}
+
+void EventFd::clear()
+{
+    Counter ignore_count;
+    checkRead(read(fd, &ignore_count, sizeof(ignore_count)));
+}
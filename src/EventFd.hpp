@@ -0,0 +1,17 @@
+#pragma once
+
+#include "FileDescriptor.hpp"
+
+class EventFd
+{
+public:
+    EventFd();
+
+    operator FD() const;
+
+    void signal();
+    void clear();
+
+private:
+    FileDescriptor fd;
+};
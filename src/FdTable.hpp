@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include "Typedefs.hpp"
+
+// Per-fd state indexed directly by the fd number. Slots live in fixed chunks that are allocated on first use and never
+// move, so a lookup is two array indexings and never takes a lock. Each slot is expected to be touched by one thread
+// at a time - the one handling that fd.
+template <class T>
+class FdTable
+{
+public:
+    FdTable() = default;
+    FdTable(const FdTable&) = delete;
+    FdTable& operator=(const FdTable&) = delete;
+
+    ~FdTable()
+    {
+        for (auto& chunk : chunks)
+            delete chunk.load(std::memory_order_relaxed);
+    }
+
+    T& operator[](FD fd)
+    {
+        if (fd < 0 or static_cast<Size>(fd) >= chunk_size * max_chunks)
+            throw std::out_of_range{"fd " + std::to_string(fd) + " does not fit into the fd table"};
+
+        auto& chunk = chunks[fd / chunk_size];
+        auto* existing = chunk.load(std::memory_order_acquire);
+        if (not existing)
+        {
+            auto created = std::make_unique<Chunk>();
+            if (chunk.compare_exchange_strong(existing, created.get(), std::memory_order_acq_rel))
+                existing = created.release();
+        }
+        return (*existing)[fd % chunk_size];
+    }
+
+private:
+    static constexpr Size chunk_size = 1024;
+    static constexpr Size max_chunks = 1024;
+    using Chunk = std::array<T, chunk_size>;
+
+    std::array<std::atomic<Chunk*>, max_chunks> chunks{};
+};
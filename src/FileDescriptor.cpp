@@ -10,7 +10,8 @@ FileDescriptor::~FileDescriptor()
     close();
 }
 
-FileDescriptor::FileDescriptor(FileDescriptor&& other) noexcept : fd(move(other.fd))
+FileDescriptor::FileDescriptor(FileDescriptor&& other) noexcept
+    : fd(move(other.fd)), should_close(other.should_close)
 {
     other.should_close = false;
 }
@@ -21,6 +22,8 @@ FileDescriptor& FileDescriptor::operator=(FileDescriptor&& other) noexcept
     {
         close();
         fd = move(other.fd);
+        // ownership travels with the fd - close() above cleared ours, e.g. when SocketUnixForked replaces its Epoll
+        should_close = other.should_close;
         other.should_close = false;
     }
     return *this;
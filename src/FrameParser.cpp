@@ -0,0 +1,72 @@
+#include "FrameParser.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    Size payloadSize(const char* header)
+    {
+        u32 length;
+        memcpy(&length, header, sizeof(length));
+        const Size size = ntohl(length);
+        if (size > max_frame_size)
+            throw runtime_error{"Frame of " + to_string(size) + " bytes exceeds the limit of " +
+                                to_string(max_frame_size)};
+        return size;
+    }
+} // namespace
+
+ChatMessage frameHeader(Size payload_size)
+{
+    const u32 length = htonl(payload_size);
+    return {reinterpret_cast<const char*>(&length), sizeof(length)};
+}
+
+const FrameParser::Frames& FrameParser::parse(string_view data)
+{
+    frames.clear();
+    completed.clear();
+
+    if (not partial.empty())
+    {
+        if (partial.size() < frame_header_size)
+        {
+            const auto taken = min(frame_header_size - partial.size(), data.size());
+            partial.append(data.substr(0, taken));
+            data.remove_prefix(taken);
+            if (partial.size() < frame_header_size)
+                return frames;
+            partial.reserve(expectedSize());
+        }
+
+        const auto taken = min(expectedSize() - partial.size(), data.size());
+        partial.append(data.substr(0, taken));
+        data.remove_prefix(taken);
+        if (partial.size() < expectedSize())
+            return frames;
+
+        swap(completed, partial);
+        partial.clear();
+        frames.push_back(string_view{completed}.substr(frame_header_size));
+    }
+
+    while (data.size() >= frame_header_size)
+    {
+        const auto frame_size = frame_header_size + payloadSize(data.data());
+        if (data.size() < frame_size)
+            break;
+        frames.push_back(data.substr(frame_header_size, frame_size - frame_header_size));
+        data.remove_prefix(frame_size);
+    }
+
+    partial.assign(data);
+    return frames;
+}
+
+Size FrameParser::expectedSize() const
+{
+    return frame_header_size + payloadSize(partial.data());
+}
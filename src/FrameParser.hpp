@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include "Typedefs.hpp"
+
+// Messages on byte streams travel as a 4-byte big-endian length followed by the payload
+constexpr Size frame_header_size = 4;
+constexpr Size max_frame_size = 16 * 1024 * 1024;
+
+ChatMessage frameHeader(Size payload_size);
+
+// Incremental per-connection parser. Complete frames are handed out as views straight into the received data - only
+// a frame split across reads is copied, and only its own bytes.
+class FrameParser
+{
+public:
+    using Frames = std::vector<std::string_view>;
+
+    // the views stay valid until the next parse or until the received data is overwritten; throws on a bogus length
+    const Frames& parse(std::string_view data);
+
+private:
+    Size expectedSize() const;
+
+    ChatMessage partial;
+    ChatMessage completed;
+    Frames frames;
+};
@@ -0,0 +1,252 @@
+#include "IoUring.hpp"
+#include <cstring>
+#include <poll.h>
+#include <tools/ThreadSafeLogger.hpp>
+#include "SocketErrorChecks.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr auto queue_depth = 4096;
+    constexpr auto buffer_count = 64;
+    constexpr auto buffer_group = 0;
+    constexpr auto no_flags = 0;
+    constexpr auto operation_shift = 32;
+    constexpr auto generation_shift = 40;
+    constexpr auto id_mask = (u64{1} << operation_shift) - 1;
+    constexpr auto operation_mask = (u64{1} << (generation_shift - operation_shift)) - 1;
+    constexpr auto generation_mask = (u64{1} << (64 - generation_shift)) - 1;
+
+    auto hasMore(const io_uring_cqe& cqe) { return cqe.flags & IORING_CQE_F_MORE; }
+} // namespace
+
+IoUring::IoUring(BufferPool<IOBuffer>& pool)
+{
+    checkIoUring(io_uring_queue_init(queue_depth, &ring, no_flags));
+
+    int result = 0;
+    buffer_ring = io_uring_setup_buf_ring(&ring, buffer_count, buffer_group, no_flags, &result);
+    checkIoUring(result);
+
+    // multishot receives pick buffers from this ring - the kernel only ever writes into pool buffers we own
+    const auto mask = io_uring_buf_ring_mask(buffer_count);
+    for (BufferId id = 0; id < buffer_count; ++id)
+    {
+        buffers.push_back(pool.get());
+        io_uring_buf_ring_add(buffer_ring, buffers.back()->data(), buffers.back()->size(), id, mask, id);
+    }
+    io_uring_buf_ring_advance(buffer_ring, buffer_count);
+    completions.reserve(queue_depth);
+
+    DEBUG_LOG << "Created io_uring: fd = " << ring.ring_fd << ", buffers = " << buffer_count;
+}
+
+IoUring::~IoUring()
+{
+    io_uring_free_buf_ring(&ring, buffer_ring, buffer_count, buffer_group);
+    io_uring_queue_exit(&ring);
+}
+
+IoUring::operator FD() const
+{
+    return ring.ring_fd;
+}
+
+void IoUring::poll(FD fd)
+{
+    // one-shot on purpose: it is rearmed only after the handler ran, which gives the level-triggered behaviour
+    // of Epoll, whereas a multishot poll would not fire again for data that is already queued
+    polled_fds.insert(fd);
+    io_uring_prep_poll_add(getSqe(Operation::Poll, fd, generation(fd)), fd, POLLIN);
+}
+
+void IoUring::pollWritable(FD fd)
+{
+    writable_polled_fds.insert(fd);
+    io_uring_prep_poll_add(getSqe(Operation::PollWritable, fd, generation(fd)), fd, POLLOUT);
+}
+
+void IoUring::receive(FD fd)
+{
+    received_fds.insert(fd);
+    auto sqe = getSqe(Operation::Receive, fd, generation(fd));
+    io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, no_flags);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group;
+}
+
+void IoUring::cancel(FD fd)
+{
+    polled_fds.erase(fd);
+    writable_polled_fds.erase(fd);
+    received_fds.erase(fd);
+    // the fd number is reused once closed, so completions of the cancelled requests must not be taken for a new socket
+    ++generations[fd];
+    io_uring_prep_cancel_fd(getSqe(Operation::Cancel, fd), fd, IORING_ASYNC_CANCEL_ALL);
+    // pending requests hold a reference to the socket, so it would outlive close() if this was left queued
+    checkIoUring(io_uring_submit(&ring));
+}
+
+Size IoUring::watchedFdCount() const
+{
+    // every fd that is polled or received keeps a request in the ring until it is cancelled
+    return polled_fds.size() + received_fds.size();
+}
+
+void IoUring::send(FD fd, const ChatMessage& msg, const ControlBuffer& control)
+{
+    send(fd, make_shared<const ChatMessage>(msg), control);
+}
+
+void IoUring::send(FD fd, SharedChatMessage msg, const ControlBuffer& control)
+{
+    // submitted together with everything else on the next wait()
+    const auto id = next_send_id++;
+    auto& pending = pending_sends.emplace(id, PendingSend{move(msg), control, {}, {}}).first->second;
+    const auto& data = *pending.data;
+    const auto sqe = getSqe(Operation::Send, id);
+    if (pending.control.empty())
+        return io_uring_prep_send(sqe, fd, data.data(), data.size(), no_flags);
+
+    pending.iov = {const_cast<char*>(data.data()), data.size()};
+    pending.header.msg_iov = &pending.iov;
+    pending.header.msg_iovlen = 1;
+    pending.header.msg_control = pending.control.data();
+    pending.header.msg_controllen = pending.control.size();
+    io_uring_prep_sendmsg(sqe, fd, &pending.header, no_flags);
+}
+
+void IoUring::submit()
+{
+    checkIoUring(io_uring_submit(&ring));
+}
+
+IoUring::Completions IoUring::wait(Timeout timeout)
+{
+    recycleBuffers();
+    completions.clear();
+
+    __kernel_timespec timeout_ts{};
+    timeout_ts.tv_sec = chrono::duration_cast<chrono::seconds>(timeout).count();
+    timeout_ts.tv_nsec = chrono::duration_cast<chrono::nanoseconds>(timeout % chrono::seconds{1}).count();
+    io_uring_cqe* cqe = nullptr;
+    constexpr auto wait_for_one = 1;
+    constexpr auto default_sigmask = nullptr;
+    checkIoUringWait(io_uring_submit_and_wait_timeout(&ring, &cqe, wait_for_one, &timeout_ts, default_sigmask));
+
+    array<io_uring_cqe*, queue_depth> cqes;
+    const auto count = io_uring_peek_batch_cqe(&ring, cqes.data(), cqes.size());
+    for (auto i = 0u; i < count; ++i)
+        handle(*cqes[i]);
+    io_uring_cq_advance(&ring, count);
+
+    return completions;
+}
+
+IoUring::Generation IoUring::generation(FD fd) const
+{
+    const auto it = generations.find(fd);
+    return it == generations.end() ? Generation{} : it->second & generation_mask;
+}
+
+io_uring_sqe* IoUring::getSqe(Operation operation, u32 id, Generation generation)
+{
+    auto sqe = io_uring_get_sqe(&ring);
+    if (not sqe)
+    {
+        checkIoUring(io_uring_submit(&ring));
+        sqe = io_uring_get_sqe(&ring);
+    }
+    io_uring_sqe_set_data64(
+        sqe, u64{generation} << generation_shift | static_cast<u64>(operation) << operation_shift | id);
+    return sqe;
+}
+
+void IoUring::recycleBuffers()
+{
+    const auto mask = io_uring_buf_ring_mask(buffer_count);
+    auto offset = 0;
+    for (auto id : used_buffers)
+        io_uring_buf_ring_add(buffer_ring, buffers[id]->data(), buffers[id]->size(), id, mask, offset++);
+    io_uring_buf_ring_advance(buffer_ring, offset);
+    used_buffers.clear();
+}
+
+void IoUring::handle(const io_uring_cqe& cqe)
+{
+    const auto user_data = io_uring_cqe_get_data64(&cqe);
+    const auto id = static_cast<u32>(user_data & id_mask);
+    // only meaningful for requests keyed by fd
+    const auto stale = [&] { return (user_data >> generation_shift) != generation(id); };
+    switch (static_cast<Operation>(user_data >> operation_shift & operation_mask))
+    {
+        case Operation::Poll:
+            if (not stale())
+                handlePoll(id, cqe);
+            return;
+        case Operation::PollWritable:
+            if (not stale())
+                handlePollWritable(id, cqe);
+            return;
+        case Operation::Receive: return handleReceive(id, cqe, stale());
+        case Operation::Send: return handleSend(id, cqe);
+        case Operation::Cancel: return;
+    }
+}
+
+void IoUring::handlePoll(FD fd, const io_uring_cqe& cqe)
+{
+    if (not polled_fds.count(fd))
+        return;
+
+    if (cqe.res < 0)
+        WARN_LOG << "Poll failed on fd = " << fd << ": " << strerror(-cqe.res);
+    else
+        completions.push_back({fd, cqe.res, {}});
+
+    poll(fd);
+}
+
+void IoUring::handlePollWritable(FD fd, const io_uring_cqe& cqe)
+{
+    // errors are reported too - the owner learns the actual outcome from SO_ERROR
+    if (writable_polled_fds.erase(fd))
+        completions.push_back({fd, cqe.res, {}, true});
+}
+
+void IoUring::handleReceive(FD fd, const io_uring_cqe& cqe, bool stale)
+{
+    string_view data;
+    if (cqe.flags & IORING_CQE_F_BUFFER)
+    {
+        const BufferId id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        used_buffers.push_back(id);
+        data = {buffers[id]->data(), static_cast<Size>(max(cqe.res, 0))};
+    }
+
+    // the buffer is recycled either way, but a stale completion belongs to a socket that is gone
+    if (stale or not received_fds.count(fd))
+        return;
+
+    if (cqe.res == -ENOBUFS)
+    {
+        DEBUG_LOG << "Ran out of receive buffers on fd = " << fd << ", rearming";
+        return receive(fd);
+    }
+
+    completions.push_back({fd, cqe.res, data});
+
+    if (cqe.res > 0 and not hasMore(cqe))
+        receive(fd);
+}
+
+void IoUring::handleSend(SendId id, const io_uring_cqe& cqe)
+{
+    const auto pending = pending_sends.find(id);
+    if (cqe.res < 0)
+        WARN_LOG << "Send failed: " << strerror(-cqe.res);
+    else if (static_cast<Size>(cqe.res) < pending->second.data->size())
+        WARN_LOG << "Short send: " << cqe.res << " out of " << pending->second.data->size() << " bytes";
+    pending_sends.erase(pending);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <liburing.h>
+#include <map>
+#include <string_view>
+#include <tools/BufferPool.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include "Typedefs.hpp"
+
+// Completion-based alternative to Epoll. Not thread-safe - meant to be driven from the network task thread only.
+class IoUring
+{
+public:
+    using Timeout = std::chrono::milliseconds;
+
+    struct Completion
+    {
+        FD fd;
+        int result;
+        std::string_view data; // only set for multishot receives, valid until the next wait()
+        bool writable = false; // set for pollWritable
+    };
+    using Completions = std::vector<Completion>;
+
+    explicit IoUring(BufferPool<IOBuffer>&);
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    operator FD() const;
+
+    void poll(FD);
+    void pollWritable(FD); // one-shot, for connects in progress
+    void receive(FD);
+    void cancel(FD);
+    Size watchedFdCount() const;
+    void send(FD, const ChatMessage&, const ControlBuffer& = {});
+    void send(FD, SharedChatMessage, const ControlBuffer& = {}); // the payload is kept alive, not copied
+    void submit();
+    Completions wait(Timeout = Timeout{100});
+
+private:
+    using BufferId = u16;
+    using SendId = u32;
+    using Generation = u32;
+
+    enum class Operation : u64
+    {
+        Poll,
+        PollWritable,
+        Receive,
+        Send,
+        Cancel
+    };
+
+    Generation generation(FD) const;
+    io_uring_sqe* getSqe(Operation, u32 id, Generation = {});
+    void recycleBuffers();
+    void handle(const io_uring_cqe&);
+    void handlePoll(FD, const io_uring_cqe&);
+    void handlePollWritable(FD, const io_uring_cqe&);
+    void handleReceive(FD, const io_uring_cqe&, bool stale);
+    void handleSend(SendId, const io_uring_cqe&);
+
+    io_uring ring;
+    io_uring_buf_ring* buffer_ring;
+    std::vector<BufferPool<IOBuffer>::BufferPtr> buffers;
+    std::vector<BufferId> used_buffers;
+    std::unordered_set<FD> polled_fds;
+    std::unordered_set<FD> writable_polled_fds;
+    std::unordered_set<FD> received_fds;
+    std::unordered_map<FD, Generation> generations; // bumped on cancel, carried in user_data of every fd request
+    struct PendingSend
+    {
+        SharedChatMessage data;
+        ControlBuffer control;
+        iovec iov;
+        msghdr header;
+    };
+    std::map<SendId, PendingSend> pending_sends;
+    SendId next_send_id{};
+    Completions completions;
+};
@@ -1,7 +1,10 @@
 #include "NetworkConfiguration.hpp"
+#include <optional>
+#include <tuple>
 #include <tools/ExtendedRangeStlAlgorithms.hpp>
 #include <tools/ThreadSafeLogger.hpp>
 #include <tools/ToLower.hpp>
+#include "SocketConfiguration.hpp"
 
 using namespace std;
 
@@ -17,6 +20,88 @@ static auto getProtocol(Arg arg)
     return protocol[toLower(arg)];
 }
 
+static auto getIoBackend(Arg arg)
+{
+    map<Arg, IoBackend> io_backend = {{"epoll", IoBackend::Epoll}, {"uring", IoBackend::IoUring}};
+    return io_backend[toLower(arg)];
+}
+
+static auto getStreamPolicy(Arg arg)
+{
+    map<Arg, StreamPolicy> stream_policy = {
+        {"rr", StreamPolicy::RoundRobin}, {"hash", StreamPolicy::Hash}, {"explicit", StreamPolicy::Explicit}};
+    return stream_policy[toLower(arg)];
+}
+
+static auto getStreamScheduler(Arg arg)
+{
+    map<Arg, StreamScheduler> stream_scheduler = {{"fcfs", StreamScheduler::FirstComeFirstServed},
+                                                  {"prio", StreamScheduler::Priority},
+                                                  {"rr", StreamScheduler::RoundRobin},
+                                                  {"fc", StreamScheduler::FairCapacity}};
+    return stream_scheduler[toLower(arg)];
+}
+
+static auto getOverflowPolicy(Arg arg)
+{
+    map<Arg, OverflowPolicy> overflow_policy = {{"drop", OverflowPolicy::Drop}, {"block", OverflowPolicy::Block}};
+    return overflow_policy[toLower(arg)];
+}
+
+static SocketParam getGsoSize(Arg arg)
+{
+    // a segment has to fit into one UDP datagram, anything else would leave nothing to cut up
+    constexpr auto max_gso_size = 65507;
+    const auto gso_size = stoi(arg);
+    if (gso_size >= 1 and gso_size <= max_gso_size)
+        return gso_size;
+    WARN_LOG << "-gso " << arg << " is outside 1.." << max_gso_size << ", sending without segmentation offload";
+    return 0;
+}
+
+static pair<Arg, Arg> splitPair(const Arg& arg)
+{
+    // <first>:<second>, the second part may contain further colons
+    const auto separator = arg.find(':');
+    return {arg.substr(0, separator), arg.substr(separator + 1)};
+}
+
+static optional<pair<SocketParam, SocketParam>> getBounds(Arg option, Arg arg)
+{
+    // <min>:<max>, clamp() has no valid range to offer when min exceeds max
+    if (arg.find(':') != Arg::npos)
+    {
+        const auto [min, max] = splitPair(arg);
+        const auto bounds = make_pair<SocketParam, SocketParam>(stoi(min), stoi(max));
+        if (bounds.first >= 1 and bounds.first <= bounds.second)
+            return bounds;
+    }
+    WARN_LOG << option << " " << arg << " is not <min>:<max> with 1 <= min <= max, keeping the defaults";
+    return {};
+}
+
+static optional<SocketParam> getSackDelayMax(Arg arg)
+{
+    // the kernel refuses delayed SACK timeouts above 500 ms
+    constexpr auto max_sack_delay = 500;
+    const auto sack_delay_max = stoi(arg);
+    if (sack_delay_max >= 1 and sack_delay_max <= max_sack_delay)
+        return sack_delay_max;
+    WARN_LOG << "-sack_max " << arg << " is outside 1.." << max_sack_delay << ", keeping the default";
+    return {};
+}
+
+static optional<SocketParam> getPfThreshold(Arg arg)
+{
+    // a path has to turn potentially failed before it is declared dead, or there is no failover window left
+    const auto pf_threshold = stoi(arg);
+    if (pf_threshold >= 0 and pf_threshold < sctp_path_max_retrans)
+        return pf_threshold;
+    WARN_LOG << "-pf " << arg << " has to be below the path max retrans of " << sctp_path_max_retrans
+             << ", keeping the default";
+    return {};
+}
+
 NetworkConfiguration::NetworkConfiguration(const Args& args)
 {
     IPSockets* filling = &locals;
@@ -28,16 +113,110 @@ NetworkConfiguration::NetworkConfiguration(const Args& args)
         {
             if (arg == "-p")
                 protocol = getProtocol(args[++i]);
+            else if (arg == "-io")
+                io_backend = getIoBackend(args[++i]);
             else if (arg == "-mtu")
                 path_mtu = stoi(args[++i]);
             else if (arg == "-seg")
                 max_seg = stoi(args[++i]);
+            else if (arg == "-gso")
+                gso_size = getGsoSize(args[++i]);
+            else if (arg == "-ostreams")
+                out_streams = stoi(args[++i]);
+            else if (arg == "-istreams")
+                max_in_streams = stoi(args[++i]);
+            else if (arg == "-stream_policy")
+                stream_policy = getStreamPolicy(args[++i]);
+            else if (arg == "-scheduler")
+                stream_scheduler = getStreamScheduler(args[++i]);
+            else if (arg == "-prio")
+            {
+                // -prio <stream>:<priority>, lower values are served first by the priority scheduler
+                const auto [stream, priority] = splitPair(args[++i]);
+                stream_priorities[stoi(stream)] = stoi(priority);
+            }
+            else if (arg == "-pr")
+                default_pr_info = toPrInfo(args[++i]).value_or(default_pr_info);
+            else if (arg == "-pr_stream")
+            {
+                // -pr_stream <stream>:<policy>:<value>
+                const auto [stream, pr_info] = splitPair(args[++i]);
+                if (const auto parsed = toPrInfo(pr_info))
+                    stream_pr_infos[stoi(stream)] = *parsed;
+            }
+            else if (arg == "-idata")
+                interleaving = true;
+            else if (arg == "-pd_point")
+                partial_delivery_point = stoi(args[++i]);
+            else if (arg == "-interleave")
+                fragment_interleave = stoi(args[++i]);
+            else if (arg == "-tune")
+                tune = true;
+            else if (arg == "-rto_bounds")
+            {
+                if (const auto bounds = getBounds(arg, args[++i]))
+                    tie(tuning_bounds.rto_min, tuning_bounds.rto_max) = *bounds;
+            }
+            else if (arg == "-hb_bounds")
+            {
+                if (const auto bounds = getBounds(arg, args[++i]))
+                    tie(tuning_bounds.hb_min, tuning_bounds.hb_max) = *bounds;
+            }
+            else if (arg == "-sack_max")
+                tuning_bounds.sack_delay_max = getSackDelayMax(args[++i]).value_or(tuning_bounds.sack_delay_max);
+            else if (arg == "-path_manager")
+                manage_paths = true;
+            else if (arg == "-pf")
+                pf_threshold = getPfThreshold(args[++i]).value_or(pf_threshold);
+            else if (arg == "-stats")
+                stats_period = Delay{stoi(args[++i])};
+            else if (arg == "-stats_file")
+                stats_file = args[++i];
+            else if (arg == "-stats_endpoint")
+                stats_endpoint = args[++i];
+            else if (arg == "-asconf")
+                asconf = true;
+            else if (arg == "-connect_timeout")
+                connect_timeout = Delay{stoi(args[++i])};
+            else if (arg == "-sendq")
+            {
+                // -sendq <low>:<high> in bytes
+                const auto [low, high] = splitPair(args[++i]);
+                send_queue_limits.low_watermark = stoul(low);
+                send_queue_limits.high_watermark = stoul(high);
+            }
+            else if (arg == "-overflow")
+                send_queue_limits.overflow_policy = getOverflowPolicy(args[++i]);
+            else if (arg == "-block_timeout")
+                send_queue_limits.block_timeout = Delay{stoi(args[++i])};
+            else if (arg == "-batch")
+                batch_delay = Delay{stoi(args[++i])};
+            else if (arg == "-batch_bytes")
+                batch_bytes = stoul(args[++i]);
             else if (arg == "-msg")
                 big_msg_size = stoi(args[++i]);
+            else if (arg == "-threads")
+                threads = stoul(args[++i]);
+            else if (arg == "-steer_cpu")
+                steer_by_cpu = true;
+            else if (arg == "-backlog")
+                listen_backlog = stoi(args[++i]);
+            else if (arg == "-no_peeloff")
+                peel_off = false;
+            else if (arg == "-load_report")
+                load_report_period = Delay{stoi(args[++i])};
+            else if (arg == "-chatter")
+                chatter_period = Delay{stoi(args[++i])};
+            else if (arg == "-bench")
+                bench_associations = stoul(args[++i]);
             else if (arg == "-r")
                 filling = &remotes;
         }
         else
             filling->push_back(IPSocket{arg, static_cast<Port>(stoi(args[++i]))});
     }
+
+    // the byte budget alone would hold a quiet peer's messages forever, so only the time budget turns batching on
+    if (batch_delay.count())
+        send_queue_limits.batch_bytes = batch_bytes;
 }
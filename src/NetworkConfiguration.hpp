@@ -1,7 +1,14 @@
 #pragma once
 
+#include <map>
 #include <tools/Args.hpp>
+#include "IoBackend.hpp"
 #include "NetworkProtocol.hpp"
+#include "PrPolicy.hpp"
+#include "SendQueue.hpp"
+#include "SctpTuner.hpp"
+#include "StreamPolicy.hpp"
+#include "StreamScheduler.hpp"
 #include "Typedefs.hpp"
 
 struct NetworkConfiguration
@@ -11,7 +18,38 @@ struct NetworkConfiguration
     LocalIPSockets locals;
     RemoteIPSockets remotes;
     NetworkProtocol protocol;
+    IoBackend io_backend = IoBackend::Epoll;
     SocketParam path_mtu{};
     SocketParam max_seg{};
+    SocketParam gso_size{};
+    SocketParam out_streams{};
+    SocketParam max_in_streams{};
+    SocketParam partial_delivery_point{};
+    SocketParam fragment_interleave{};
+    StreamPolicy stream_policy = StreamPolicy::Explicit;
+    StreamScheduler stream_scheduler = StreamScheduler::FirstComeFirstServed;
+    std::map<StreamId, SocketParam> stream_priorities;
+    bool interleaving = false;
+    PrInfo default_pr_info;
+    std::map<StreamId, PrInfo> stream_pr_infos;
+    bool tune = false;
+    TuningBounds tuning_bounds;
+    bool manage_paths = false;
+    bool asconf = false;
+    SocketParam pf_threshold = 1;
+    Delay stats_period{};
+    std::string stats_file;
+    std::string stats_endpoint;
+    Delay connect_timeout{3000};
+    SendQueueLimits send_queue_limits;
+    Delay batch_delay{};
+    Size batch_bytes = 64 * 1024;
     Size big_msg_size{};
+    Size threads = 1;
+    bool steer_by_cpu = false;
+    SocketParam listen_backlog = 10;
+    bool peel_off = true;
+    Delay load_report_period{};
+    Delay chatter_period{};
+    Size bench_associations{};
 };
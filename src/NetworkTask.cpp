@@ -1,61 +1,227 @@
 #include "NetworkTask.hpp"
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tools/AsyncTask.hpp>
+#include <tools/ContainerOperators.hpp>
 #include <tools/ErrorChecks.hpp>
-#include <tools/TaskScheduler.hpp>
 #include "Chat.hpp"
 #include "Constants.hpp"
 #include "Socket.hpp"
 #include "SocketFactory.hpp"
 #include "StartTask.hpp"
+#include "TimerFd.hpp"
+#include "TimerWheel.hpp"
 
 using namespace std;
 
 namespace
 {
-    auto establishSocket(const NetworkConfiguration& config, TaskScheduler& ts)
+    using ShardIndex = Size;
+    using ShouldConnect = bool;
+
+    constexpr auto wait_forever = Epoll::Timeout{-1};
+    // shared memory and semaphores of SocketUnixForked cannot be waited on, so that socket still gets polled
+    constexpr auto unix_forked_poll_period = Epoll::Timeout{100};
+    constexpr auto dont_block = Socket::Timeout{0};
+    constexpr auto forever = numeric_limits<TimerWheel::Repetitions>::max();
+    constexpr auto chatter_msg = "chatter";
+
+    auto establishSocket(const NetworkConfiguration& config, TimerWheel& ts, ShouldConnect should_connect)
     {
         auto socket = createSocket(config, ts);
-        socket->listen(BacklogCount{10});
-        socket->connect(config.remotes);
+        if (config.io_backend == IoBackend::IoUring)
+            socket->useIoUring();
+        socket->listen(BacklogCount{config.listen_backlog});
+        if (should_connect)
+            socket->connect(config.remotes);
         return socket;
     }
 
-    auto chatOrQuit(Socket& socket)
+    // SO_REUSEPORT numbers the sockets of a group in the order they listen, and the CPU steering filter picks member
+    // cpu % threads - so shard i has to join as the i-th member, and with one shard per core that is the shard pinned
+    // to the core that received the connection
+    class ShardTurns
+    {
+    public:
+        template <typename Action>
+        auto take(ShardIndex index, Action action)
+        {
+            unique_lock<mutex> lock{mtx};
+            turn_changed.wait(lock, [&] { return next == index; });
+            // the next shard gets its turn even when this one fails, it would wait forever otherwise
+            struct Pass
+            {
+                ShardTurns& turns;
+                ~Pass()
+                {
+                    ++turns.next;
+                    turns.turn_changed.notify_all();
+                }
+            } pass{*this};
+            return action();
+        }
+
+    private:
+        mutex mtx;
+        condition_variable turn_changed;
+        ShardIndex next{};
+    };
+
+    auto isCommand(const ChatMessage& msg, string_view command) { return msg.starts_with(command); }
+    auto commandArg(const ChatMessage& msg, string_view command) { return msg.substr(command.size()); }
+
+    void sendPartiallyReliable(Socket& socket, const ChatMessage& arg)
+    {
+        // <policy>:<value> <message>, the policy only applies to this one message
+        const auto separator = arg.find(' ');
+        optional<PrInfo> pr_info;
+        try
+        {
+            if (separator == ChatMessage::npos)
+                throw invalid_argument{"no message"};
+            pr_info = toPrInfo(arg.substr(0, separator));
+        }
+        catch (const logic_error&)
+        {
+            WARN_LOG << "Expected " << pr_msg_cmd << "<policy>:<value> <message>, got " << pr_msg_cmd << arg;
+            return;
+        }
+        if (pr_info)
+            socket.sendPartiallyReliable(arg.substr(separator + 1), *pr_info);
+    }
+
+    auto chatOrQuit(Socket& socket, ChatInbox& inbox)
     {
-        const auto& msg = chat();
-        if (not msg.empty())
+        for (const auto& msg : inbox.drain())
         {
-            if (msg != quit_msg)
+            if (msg == quit_msg)
+                return msg;
+            if (isCommand(msg, add_address_cmd))
+                socket.addLocalAddress(commandArg(msg, add_address_cmd));
+            else if (isCommand(msg, remove_address_cmd))
+                socket.removeLocalAddress(commandArg(msg, remove_address_cmd));
+            else if (isCommand(msg, pr_msg_cmd))
+                sendPartiallyReliable(socket, commandArg(msg, pr_msg_cmd));
+            else if (not msg.empty())
                 socket.send(msg);
-            else
-                chat(msg);
         }
-        return msg;
+        return ChatMessage{};
     }
-} // namespace
 
-void networkTask(const NetworkTaskParams& p) try
-{
-    startTask(p.name, p.delay);
+    Size shardCount(const NetworkConfiguration& config)
+    {
+        if (config.threads <= 1 or isUnix(config.protocol))
+            return 1;
 
-    TaskScheduler ts;
+        // Linux only accepts SCTP_REUSE_PORT on one-to-one style sockets, and this one is one-to-many
+        if (config.protocol == NetworkProtocol::SCTP)
+        {
+            WARN_LOG << "SCTP endpoints cannot share a port - running a single shard";
+            return 1;
+        }
 
-    auto socket = establishSocket(p.config, ts);
+        return config.threads;
+    }
 
-    const auto should_live_forever = p.lifetime == 0ms;
-    if (not should_live_forever)
+    auto shardConfig(NetworkConfiguration config, ShardIndex index)
     {
-        DEBUG_LOG << "This task will die in " << p.lifetime.count() << "ms";
+        // every shard samples only its own associations, so it gets a stats file and endpoint of its own
+        const auto suffix = "." + to_string(index);
+        if (config.threads > 1 and not config.stats_file.empty())
+            config.stats_file += suffix;
+        if (config.threads > 1 and not config.stats_endpoint.empty())
+            config.stats_endpoint += suffix;
+        return config;
     }
 
-    const auto time_to_die = now() + p.lifetime;
-    ChatMessage send_msg;
-    while ((should_live_forever or now() < time_to_die) and send_msg != quit_msg)
+    void runShard(
+        const NetworkTaskParams& p, const NetworkConfiguration& shared_config, ShardTurns& turns, ShardIndex index) try
     {
-        ts.launch();
-        socket->receive();
-        send_msg = chatOrQuit(*socket);
+        const auto config = shardConfig(shared_config, index);
+        const auto is_sharded = config.threads > 1;
+        if (is_sharded)
+            startTask(p.name + "#" + to_string(index));
+
+        TimerWheel ts;
+
+        // the kernel spreads incoming connections over the shards, but outgoing ones are only made once
+        auto socket = turns.take(index, [&] {
+            if (is_sharded)
+                pinToCore(index);
+            return establishSocket(config, ts, ShouldConnect{index == 0});
+        });
+        if (is_sharded)
+            socket->handleOnCallingThread();
+
+        const auto should_live_forever = p.lifetime == 0ms;
+        if (not should_live_forever)
+        {
+            DEBUG_LOG << "This task will die in " << p.lifetime.count() << "ms";
+            constexpr auto wake_up = [] {};
+            ts.schedule(wake_up, p.lifetime);
+        }
+
+        // steady traffic without a console, e.g. for the load reports of -bench
+        if (config.chatter_period.count())
+            ts.schedule([&socket] { socket->send(chatter_msg); }, config.chatter_period, forever);
+
+        // the only place the task blocks - sockets, chat input and the next due timer all wake it up
+        ChatInbox chat_inbox;
+        TimerFd scheduler_timer;
+        Epoll wakeups;
+        wakeups.add(socket->pollFd());
+        wakeups.add(chat_inbox);
+        wakeups.add(scheduler_timer);
+
+        const auto max_wait = config.protocol == NetworkProtocol::UnixForked ? unix_forked_poll_period : wait_forever;
+        const auto time_to_die = now() + p.lifetime;
+        ChatMessage send_msg;
+        while ((should_live_forever or now() < time_to_die) and send_msg != quit_msg)
+        {
+            socket->flush();
+            if (const auto next_timer = ts.timeUntilNext())
+                scheduler_timer.arm(*next_timer);
+            else
+                scheduler_timer.disarm();
+
+            for (auto fd : wakeups.wait(max_wait))
+            {
+                if (fd == chat_inbox)
+                    chat_inbox.clearWakeup();
+                else if (fd == scheduler_timer)
+                    scheduler_timer.clear();
+            }
+
+            ts.launch();
+            socket->receive(dont_block);
+            send_msg = chatOrQuit(*socket, chat_inbox);
+        }
+
+        DEBUG_LOG << "Ending task";
     }
+    LOG_EXCEPTIONS
+} // namespace
+
+void networkTask(const NetworkTaskParams& p) try
+{
+    startTask(p.name, p.delay);
+
+    auto config = p.config;
+    config.threads = shardCount(config);
+    if (config.steer_by_cpu and config.threads > 1 and config.threads != thread::hardware_concurrency())
+        WARN_LOG << "-steer_cpu keeps connections on the receiving core only with one shard per core, "
+                 << config.threads << " shards on " << thread::hardware_concurrency() << " cores merely share them out";
+    ShardTurns turns;
+    if (config.threads == 1)
+        return runShard(p, config, turns, ShardIndex{0});
 
-    DEBUG_LOG << "Ending task";
+    DEBUG_LOG << "Running " << config.threads << " shards";
+    AsyncTasks shards;
+    for (ShardIndex i = 0; i < config.threads; ++i)
+        shards += asyncTask(runShard, p, cref(config), ref(turns), i);
+    join(shards);
 }
 LOG_EXCEPTIONS
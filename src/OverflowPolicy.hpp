@@ -0,0 +1,5 @@
+#pragma once
+
+#include <tools/EnumToString.hpp>
+
+DEFINE_ENUM_CLASS_WITH_STRING_CONVERSIONS(OverflowPolicy, (Drop)(Block))
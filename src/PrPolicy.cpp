@@ -0,0 +1,21 @@
+#include "PrPolicy.hpp"
+#include <map>
+#include <tools/ThreadSafeLogger.hpp>
+#include <tools/ToLower.hpp>
+
+using namespace std;
+
+optional<PrInfo> toPrInfo(const string& arg)
+{
+    // <policy>:<value>, e.g. ttl:100
+    const map<string, PrPolicy> pr_policy = {
+        {"none", PrPolicy::None}, {"ttl", PrPolicy::Ttl}, {"rtx", PrPolicy::Rtx}, {"prio", PrPolicy::Prio}};
+    const auto separator = arg.find(':');
+    if (separator != string::npos)
+    {
+        if (const auto policy = pr_policy.find(toLower(arg.substr(0, separator))); policy != end(pr_policy))
+            return PrInfo{policy->second, stoi(arg.substr(separator + 1))};
+    }
+    WARN_LOG << arg << " is not <policy>:<value> with a policy of none, ttl, rtx or prio, ignoring it";
+    return {};
+}
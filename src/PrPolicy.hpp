@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <tools/EnumToString.hpp>
+#include "Typedefs.hpp"
+
+DEFINE_ENUM_CLASS_WITH_STRING_CONVERSIONS(PrPolicy, (None)(Ttl)(Rtx)(Prio))
+
+// value is the lifetime in ms for Ttl, the retransmission limit for Rtx and the drop priority for Prio
+struct PrInfo
+{
+    PrPolicy policy = PrPolicy::None;
+    SocketParam value{};
+};
+
+std::optional<PrInfo> toPrInfo(const std::string&); // empty and warned about when malformed
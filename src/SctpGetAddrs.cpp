@@ -47,3 +47,15 @@ IPSockets getPaddrs(FD fd, AssocId assoc_id)
 {
     return getAddrs(fd, assoc_id, AddrType::PEER);
 }
+
+optional<sctp_paddrinfo> getPaddrInfo(FD fd, AssocId assoc_id, const sockaddr_storage& address)
+{
+    sctp_paddrinfo info{};
+    info.spinfo_assoc_id = assoc_id;
+    info.spinfo_address = address;
+    socklen_t len = sizeof(info);
+    // paths come and go underneath, a failed lookup just means this one is gone
+    if (getsockopt(fd, IPPROTO_SCTP, SCTP_GET_PEER_ADDR_INFO, &info, &len) != 0)
+        return {};
+    return info;
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <optional>
 #include "Constants.hpp"
 #include "Typedefs.hpp"
 
 IPSockets getLaddrs(FD, AssocId = ignore_assoc);
 IPSockets getPaddrs(FD, AssocId = ignore_assoc);
+std::optional<sctp_paddrinfo> getPaddrInfo(FD, AssocId, const sockaddr_storage&);
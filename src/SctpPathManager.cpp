@@ -0,0 +1,122 @@
+#include "SctpPathManager.hpp"
+#include <sstream>
+#include <tools/ComparisonOperators.hpp>
+#include <tools/ThreadSafeLogger.hpp>
+#include "SctpGetAddrs.hpp"
+#include "SocketConfiguration.hpp"
+#include "SocketIO.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr auto switch_threshold_percent = 80; // a healthy primary is only left for a path 20% faster
+
+    optional<sctp_paddrinfo> getPrimaryInfo(FD fd, AssocId assoc_id)
+    {
+        sctp_status status{};
+        status.sstat_assoc_id = assoc_id;
+        socklen_t len = sizeof(status);
+        if (::getsockopt(fd, IPPROTO_SCTP, SCTP_STATUS, &status, &len) != 0)
+            return {};
+        return status.sstat_primary;
+    }
+
+    auto isHealthy(const sctp_paddrinfo& path) { return path.spinfo_state == SCTP_ACTIVE; }
+
+    auto describe(const sctp_paddrinfo& path)
+    {
+        ostringstream os;
+        os << IPSocket{path.spinfo_address} << " (" << toString(static_cast<sctp_spinfo_state>(path.spinfo_state))
+           << ", srtt = " << path.spinfo_srtt << ")";
+        return os.str();
+    }
+} // namespace
+
+SctpPathManager::SctpPathManager(SocketParam pf_threshold) : pf_threshold(pf_threshold) {}
+
+void SctpPathManager::configure(FD fd, AssocId assoc_id)
+{
+    // a pf threshold below the path max retrans lets traffic move off a path before it is declared dead
+    configurePotentiallyFailedThreshold(fd, sctp_path_max_retrans, PfThreshold{pf_threshold}, assoc_id);
+    // otherwise SCTP_GET_PEER_ADDR_INFO may still report a potentially failed primary as active to evaluate()
+    configureExposePotentiallyFailedState(fd, assoc_id);
+    associations[assoc_id];
+}
+
+void SctpPathManager::evaluate(FD fd, AssocId assoc_id)
+{
+    const auto primary = getPrimaryInfo(fd, assoc_id);
+    if (not primary)
+        return;
+
+    optional<sctp_paddrinfo> best;
+    for (const auto& remote : getPaddrs(fd, assoc_id))
+    {
+        const auto path = getPaddrInfo(fd, assoc_id, remote);
+        // an active path has been confirmed by a HEARTBEAT ACK, which measured it, so srtt 0 means below 1 ms
+        if (not path or not isHealthy(*path))
+            continue;
+        if (not best or path->spinfo_srtt < best->spinfo_srtt)
+            best = path;
+    }
+
+    if (not best or IPSocket{best->spinfo_address} == IPSocket{primary->spinfo_address})
+        return;
+
+    const auto faster = best->spinfo_srtt * 100 < primary->spinfo_srtt * switch_threshold_percent;
+    if (not isHealthy(*primary) or faster)
+        switchPrimary(fd, assoc_id, *primary, *best);
+}
+
+void SctpPathManager::handleAddressChange(FD fd, const sctp_paddr_change& change)
+{
+    const auto assoc_id = change.spc_assoc_id;
+    auto& association = associations[assoc_id];
+
+    switch (change.spc_state)
+    {
+        case SCTP_ADDR_UNREACHABLE:
+        case SCTP_ADDR_POTENTIALLY_FAILED:
+        {
+            const auto primary = getPrimaryInfo(fd, assoc_id);
+            if (not primary or not(IPSocket{primary->spinfo_address} == IPSocket{change.spc_aaddr}))
+                return;
+            if (not association.failed_since)
+                association.failed_since = Clock::now();
+            return evaluate(fd, assoc_id);
+        }
+        case SCTP_ADDR_MADE_PRIM:
+        {
+            if (not association.failed_since)
+                return;
+            const auto failover_time = chrono::duration_cast<Delay>(Clock::now() - *association.failed_since);
+            INFO_LOG << "Failover on assoc_id = " << assoc_id << " to " << IPSocket{change.spc_aaddr} << " took "
+                     << failover_time.count() << " ms";
+            association.failed_since.reset();
+            return;
+        }
+        default: return;
+    }
+}
+
+void SctpPathManager::forget(AssocId assoc_id)
+{
+    associations.erase(assoc_id);
+}
+
+void SctpPathManager::switchPrimary(FD fd, AssocId assoc_id, const sctp_paddrinfo& from, const sctp_paddrinfo& to)
+{
+    auto& association = associations[assoc_id];
+    ++association.switches;
+    INFO_LOG << "Switching primary path of assoc_id = " << assoc_id << " from " << describe(from) << " to "
+             << describe(to) << ", switch #" << association.switches;
+    configurePrimaryAddress(fd, to.spinfo_address, assoc_id);
+
+    if (association.failed_since)
+    {
+        const auto failover_time = chrono::duration_cast<Delay>(Clock::now() - *association.failed_since);
+        INFO_LOG << "Failover on assoc_id = " << assoc_id << " took " << failover_time.count() << " ms";
+        association.failed_since.reset();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include "Typedefs.hpp"
+
+// Keeps the primary path of each multihomed association on the healthiest, lowest latency peer address. Paths are
+// measured with SCTP_GET_PEER_ADDR_INFO and the primary is moved with SCTP_PRIMARY_ADDR. A potentially failed or
+// unreachable primary is replaced right away, a healthy one only for a path that is clearly faster.
+class SctpPathManager
+{
+public:
+    explicit SctpPathManager(SocketParam pf_threshold);
+
+    void configure(FD, AssocId);
+    void evaluate(FD, AssocId);
+    void handleAddressChange(FD, const sctp_paddr_change&);
+    void forget(AssocId);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Association
+    {
+        std::optional<Clock::time_point> failed_since;
+        Size switches{};
+    };
+
+    void switchPrimary(FD, AssocId, const sctp_paddrinfo& from, const sctp_paddrinfo& to);
+
+    SocketParam pf_threshold;
+    std::map<AssocId, Association> associations;
+};
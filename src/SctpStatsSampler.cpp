@@ -0,0 +1,222 @@
+#include "SctpStatsSampler.hpp"
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <tools/ThreadSafeLogger.hpp>
+#include "SctpGetAddrs.hpp"
+#include "Socket.hpp"
+#include "SocketErrorChecks.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr auto csv_header =
+        "timestamp_ms,assoc_id,state,rwnd,unacked,pending,in_streams,out_streams,fragmentation_point,max_rto,"
+        "rtx_chunks,out_of_seq_tsns,gap_acks,packets_out,packets_in,paths (addr|state|cwnd|srtt|rto|mtu)\n";
+    constexpr auto endpoint_backlog = 4;
+    constexpr auto max_pending_readers = 16; // each holds on to a snapshot copy until it has read it
+
+    auto millisecondsSinceEpoch()
+    {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    template <class Value>
+    auto getSctpOpt(FD fd, int option, Value& value)
+    {
+        socklen_t len = sizeof(value);
+        // the association may go away between listing and sampling it, that is not an error here
+        return getsockopt(fd, IPPROTO_SCTP, option, &value, &len) == 0;
+    }
+
+    FileDescriptor listenOn(const string& path)
+    {
+        FileDescriptor fd{checkedSocket(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, default_protocol))};
+        sockaddr_un saddr{};
+        saddr.sun_family = AF_UNIX;
+        strncpy(saddr.sun_path, path.c_str(), sizeof(saddr.sun_path) - 1);
+        unlink(saddr.sun_path);
+        checkBind(::bind(fd, asSockaddrPtr(saddr), sizeof(saddr)));
+        checkListen(::listen(fd, endpoint_backlog));
+        INFO_LOG << "Serving SCTP stats on " << path << ", fd = " << fd;
+        return fd;
+    }
+} // namespace
+
+ostream& operator<<(ostream& os, const AssocSample& s)
+{
+    os << s.timestamp_ms << ',' << s.assoc_id << ',' << s.state << ',' << s.rwnd << ',' << s.unacked << ','
+       << s.pending << ',' << s.in_streams << ',' << s.out_streams << ',' << s.fragmentation_point << ','
+       << s.max_rto << ',' << s.rtx_chunks << ',' << s.out_of_seq_tsns << ',' << s.gap_acks << ',' << s.packets_out
+       << ',' << s.packets_in << ',';
+    for (auto i = 0u; i < s.path_count; ++i)
+    {
+        const auto& path = s.paths[i];
+        os << (i ? ";" : "") << IPSocket{path.address} << '|' << path.state << '|' << path.cwnd << '|' << path.srtt
+           << '|' << path.rto << '|' << path.mtu;
+    }
+    return os;
+}
+
+SctpStatsSampler::SctpStatsSampler(const string& file_path, const string& endpoint_path)
+    : endpoint_path(endpoint_path)
+{
+    if (not file_path.empty())
+    {
+        file.open(file_path, ios::app);
+        if (not file)
+            throw runtime_error{"Cannot open stats file " + file_path};
+        file << csv_header << flush;
+    }
+
+    if (not endpoint_path.empty())
+        endpoint_fd = listenOn(endpoint_path);
+}
+
+SctpStatsSampler::~SctpStatsSampler()
+{
+    flushFile();
+    if (not endpoint_path.empty())
+        unlink(endpoint_path.c_str());
+}
+
+void SctpStatsSampler::sample(FD fd, AssocId assoc_id)
+{
+    sctp_status status{};
+    status.sstat_assoc_id = assoc_id;
+    sctp_assoc_stats stats{};
+    stats.sas_assoc_id = assoc_id;
+    if (not getSctpOpt(fd, SCTP_STATUS, status) or not getSctpOpt(fd, SCTP_GET_ASSOC_STATS, stats))
+        return;
+
+    AssocSample sample{};
+    sample.timestamp_ms = millisecondsSinceEpoch();
+    sample.assoc_id = assoc_id;
+    sample.state = status.sstat_state;
+    sample.rwnd = status.sstat_rwnd;
+    sample.unacked = status.sstat_unackdata;
+    sample.pending = status.sstat_penddata;
+    sample.in_streams = status.sstat_instrms;
+    sample.out_streams = status.sstat_outstrms;
+    sample.fragmentation_point = status.sstat_fragmentation_point;
+    sample.max_rto = stats.sas_maxrto;
+    sample.rtx_chunks = stats.sas_rtxchunks;
+    sample.out_of_seq_tsns = stats.sas_outofseqtsns;
+    sample.gap_acks = stats.sas_gapcnt;
+    sample.packets_out = stats.sas_opackets;
+    sample.packets_in = stats.sas_ipackets;
+
+    for (const auto& remote : getPaddrs(fd, assoc_id))
+    {
+        if (sample.path_count == AssocSample::max_paths)
+            break;
+        if (const auto info = getPaddrInfo(fd, assoc_id, remote))
+            sample.paths[sample.path_count++] = {
+                info->spinfo_address, info->spinfo_state, info->spinfo_cwnd, info->spinfo_srtt, info->spinfo_rto,
+                info->spinfo_mtu};
+    }
+
+    ring->push(sample);
+}
+
+void SctpStatsSampler::flushFile()
+{
+    if (not file.is_open())
+        return;
+
+    vector<AssocSample> samples;
+    file_position = ring->read(file_position, samples);
+    for (const auto& sample : samples)
+        file << sample << '\n';
+    file.flush();
+}
+
+FD SctpStatsSampler::endpoint() const
+{
+    return endpoint_fd;
+}
+
+FDs SctpStatsSampler::serve()
+{
+    // runs on the thread that serves the associations too, so nothing here may ever wait for a reader
+    optional<string> snapshot;
+    FDs owed;
+    for (;;)
+    {
+        FileDescriptor client{::accept4(endpoint_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+        if (client < 0)
+        {
+            if (errno != EAGAIN and errno != EWOULDBLOCK)
+                WARN_LOG << "Accepting a stats reader on fd = " << endpoint_fd << " failed: " << strerror(errno);
+            return owed;
+        }
+
+        if (not snapshot)
+        {
+            vector<AssocSample> samples;
+            ring->read(0, samples);
+            ostringstream os;
+            os << csv_header;
+            for (const auto& sample : samples)
+                os << sample << '\n';
+            snapshot = os.str();
+        }
+
+        // a send buffer sized for the snapshot usually takes it in one write, net.core.wmem_max may cap it though
+        const int buffer_size = snapshot->size();
+        setsockopt(client, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+        const auto sent = write(client, *snapshot);
+        if (not sent or *sent == snapshot->size())
+            continue;
+
+        LOCK_MTX(pending_readers_mtx);
+        if (pending_readers.size() == max_pending_readers)
+        {
+            WARN_LOG << "Too many stats readers still being served, dropping fd = " << client;
+            continue;
+        }
+        const FD reader = client;
+        pending_readers.emplace(reader, PendingReader{move(client), snapshot->substr(*sent)});
+        owed.push_back(reader);
+    }
+}
+
+bool SctpStatsSampler::owes(FD fd) const
+{
+    LOCK_MTX(pending_readers_mtx);
+    return pending_readers.count(fd) > 0;
+}
+
+bool SctpStatsSampler::resume(FD fd)
+{
+    LOCK_MTX(pending_readers_mtx);
+    const auto reader = pending_readers.find(fd);
+    if (reader == end(pending_readers))
+        return true;
+
+    auto& rest = reader->second.rest;
+    const auto sent = write(fd, rest);
+    if (sent and *sent < rest.size())
+    {
+        rest.erase(0, *sent);
+        return false;
+    }
+    pending_readers.erase(reader);
+    return true;
+}
+
+optional<Size> SctpStatsSampler::write(FD client, string_view data)
+{
+    const auto sent = ::send(client, data.data(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0 and (errno == EAGAIN or errno == EWOULDBLOCK))
+        return 0;
+    if (sent < 0)
+    {
+        WARN_LOG << "Stats reader on fd = " << client << " went away: " << strerror(errno);
+        return {};
+    }
+    DEBUG_LOG << "Served " << sent << " bytes of stats on fd = " << client;
+    return sent;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "FileDescriptor.hpp"
+#include "StatsRing.hpp"
+
+// One point-in-time look at an association - SCTP_STATUS, SCTP_GET_ASSOC_STATS and the first few paths
+struct AssocSample
+{
+    static constexpr auto max_paths = 4;
+
+    struct Path
+    {
+        sockaddr_storage address;
+        int state;
+        u32 cwnd;
+        u32 srtt;
+        u32 rto;
+        u32 mtu;
+    };
+
+    u64 timestamp_ms;
+    AssocId assoc_id;
+    int state;
+    u32 rwnd;
+    u16 unacked;
+    u16 pending;
+    u16 in_streams;
+    u16 out_streams;
+    u32 fragmentation_point;
+    u64 max_rto;
+    u64 rtx_chunks;
+    u64 out_of_seq_tsns;
+    u64 gap_acks;
+    u64 packets_out;
+    u64 packets_in;
+    u32 path_count;
+    std::array<Path, max_paths> paths;
+};
+
+std::ostream& operator<<(std::ostream&, const AssocSample&);
+
+// Samples associations into a lock-free ring. The ring is appended to a CSV file after every round and served in
+// full to anyone connecting to the stats endpoint, a Unix stream socket. A reader whose socket cannot take the whole
+// snapshot at once is owed the rest, which the owner hands out with resume() whenever the reader becomes writable.
+class SctpStatsSampler
+{
+public:
+    SctpStatsSampler(const std::string& file_path, const std::string& endpoint_path);
+    ~SctpStatsSampler();
+
+    void sample(FD, AssocId);
+    void flushFile();
+    FD endpoint() const;
+    FDs serve(); // accepts every waiting reader without blocking, returns those still owed part of their snapshot
+    bool owes(FD) const;
+    bool resume(FD); // writes more of what the reader is owed, true once it has got everything or went away
+
+private:
+    std::optional<Size> write(FD client, std::string_view data);
+
+    struct PendingReader
+    {
+        FileDescriptor fd;
+        std::string rest;
+    };
+
+    static constexpr Size ring_capacity = 1024;
+    using Ring = StatsRing<AssocSample, ring_capacity>;
+
+    std::unique_ptr<Ring> ring = std::make_unique<Ring>();
+    std::ofstream file;
+    Ring::Index file_position{};
+    std::string endpoint_path;
+    FileDescriptor endpoint_fd;
+    // served on a worker, resumed on the network thread
+    std::map<FD, PendingReader> pending_readers;
+    mutable std::mutex pending_readers_mtx;
+};
@@ -0,0 +1,77 @@
+#include "SctpTuner.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <tools/ThreadSafeLogger.hpp>
+#include "SocketConfiguration.hpp"
+
+using namespace std;
+
+namespace
+{
+    constexpr auto sack_delay_min = 1;
+    constexpr SocketParam min_srtt = 1; // anything below 1 ms counts as 1 ms
+} // namespace
+
+SctpTuner::SctpTuner(const TuningBounds& bounds, SocketParam path_mtu) : bounds(bounds), path_mtu(path_mtu) {}
+
+void SctpTuner::tune(FD fd, AssocId assoc_id)
+{
+    sctp_status status{};
+    status.sstat_assoc_id = assoc_id;
+    socklen_t len = sizeof(status);
+    if (::getsockopt(fd, IPPROTO_SCTP, SCTP_STATUS, &status, &len) != 0)
+        return; // the association is already going down
+    const auto& primary = status.sstat_primary;
+
+    // the kernel reports RTTs in whole ms, so a LAN or loopback srtt reads 0 even once it was measured - an
+    // acknowledged DATA chunk is what tells the two apart
+    sctp_assoc_stats stats{};
+    stats.sas_assoc_id = assoc_id;
+    len = sizeof(stats);
+    const auto acked = ::getsockopt(fd, IPPROTO_SCTP, SCTP_GET_ASSOC_STATS, &stats, &len) == 0 and stats.sas_isacks;
+    if (not primary.spinfo_srtt and not acked)
+        return; // nothing measured yet
+    const SocketParam srtt = max<SocketParam>(primary.spinfo_srtt, min_srtt);
+
+    const auto params = derive(srtt);
+    auto& last = applied[assoc_id];
+    if (params == last)
+        return;
+
+    DEBUG_LOG << "Tuning assoc_id = " << assoc_id << " for srtt = " << srtt << ", cwnd = " << primary.spinfo_cwnd
+              << ", kernel rto = " << primary.spinfo_rto << ": rto = " << params.rto_initial << "/" << params.rto_min
+              << "/" << bounds.rto_max << ", sack_delay = " << params.sack_delay
+              << ", hb_interval = " << params.hb_interval;
+    try
+    {
+        configureRto(
+            fd, RtoInitialInMs{params.rto_initial}, RtoMinInMs{params.rto_min}, RtoMaxInMs{bounds.rto_max}, assoc_id);
+        configureSack(fd, sctp_sack_freq, SackDelay{params.sack_delay}, assoc_id);
+        configurePeerAddressParams(
+            fd, HbInterval{params.hb_interval}, sctp_path_max_retrans, PathMtu{path_mtu}, assoc_id);
+    }
+    catch (const runtime_error& ex)
+    {
+        // typically the association went down since SCTP_STATUS, the next round retries the rest of them
+        WARN_LOG << "Tuning assoc_id = " << assoc_id << " failed: " << ex.what();
+        return;
+    }
+    last = params;
+}
+
+void SctpTuner::forget(AssocId assoc_id)
+{
+    applied.erase(assoc_id);
+}
+
+SctpTuner::Params SctpTuner::derive(SocketParam srtt) const
+{
+    // the kernel still adds 4 * rttvar on top of srtt, these only bound what it may do
+    Params params{};
+    params.rto_min = clamp(2 * srtt, bounds.rto_min, bounds.rto_max);
+    params.rto_initial = clamp(4 * srtt, params.rto_min, bounds.rto_max);
+    // a SACK held back longer than half a round trip only delays the sender's cwnd growth
+    params.sack_delay = clamp(srtt / 2, sack_delay_min, max(sack_delay_min, bounds.sack_delay_max));
+    params.hb_interval = clamp(10 * params.rto_initial, bounds.hb_min, max(bounds.hb_min, bounds.hb_max));
+    return params;
+}
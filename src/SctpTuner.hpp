@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+#include "Typedefs.hpp"
+
+// all in ms
+struct TuningBounds
+{
+    SocketParam rto_min = 10;
+    SocketParam rto_max = 5000;
+    SocketParam sack_delay_max = 200;
+    SocketParam hb_min = 1000;
+    SocketParam hb_max = 30000;
+};
+
+// Follows the smoothed RTT of the primary path of each association and derives its RTO, delayed SACK and heartbeat
+// from it, so loss recovery takes a few round trips instead of the conservative defaults meant for the open internet.
+class SctpTuner
+{
+public:
+    SctpTuner(const TuningBounds&, SocketParam path_mtu);
+
+    void tune(FD, AssocId);
+    void forget(AssocId);
+
+private:
+    struct Params
+    {
+        SocketParam rto_initial;
+        SocketParam rto_min;
+        SocketParam sack_delay;
+        SocketParam hb_interval;
+
+        bool operator==(const Params&) const = default;
+    };
+
+    Params derive(SocketParam srtt) const;
+
+    TuningBounds bounds;
+    SocketParam path_mtu;
+    std::map<AssocId, Params> applied;
+};
@@ -0,0 +1,202 @@
+#include "SendQueue.hpp"
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <tools/ThreadSafeLogger.hpp>
+
+using namespace std;
+
+namespace
+{
+    constexpr auto max_gathered_iovecs = 64;
+    constexpr auto no_flags = 0;
+
+    bool wouldBlock() { return errno == EAGAIN or errno == EWOULDBLOCK; }
+
+    void appendIovecs(const SendQueue::Pieces& pieces, Size offset, vector<iovec>& iovecs)
+    {
+        for (const auto& piece : pieces)
+        {
+            if (offset >= piece->size())
+            {
+                offset -= piece->size();
+                continue;
+            }
+            iovecs.push_back({const_cast<char*>(piece->data()) + offset, piece->size() - offset});
+            offset = 0;
+        }
+    }
+} // namespace
+
+SendQueue::SendQueue(FD fd,
+                     PreservesBoundaries preserves_boundaries,
+                     SupportsMsgMore supports_msg_more,
+                     const SendQueueLimits& limits,
+                     BacklogChanged backlog_changed)
+    : fd(fd),
+      preserves_boundaries(preserves_boundaries),
+      more_flag(supports_msg_more ? MSG_MORE : no_flags),
+      limits(limits),
+      backlog_changed(move(backlog_changed))
+{
+}
+
+SendQueue::~SendQueue()
+{
+    if (dropped_msgs)
+        INFO_LOG << "Send queue of fd = " << fd << " dropped " << dropped_msgs << " messages";
+}
+
+bool SendQueue::send(Pieces pieces, ControlBuffer control, optional<Deadline> block_until)
+{
+    Size size = 0;
+    for (const auto& piece : pieces)
+        size += piece->size();
+    Entry entry{move(pieces), move(control), size};
+
+    lock_guard<mutex> lock{mtx};
+    if (overloaded and not(limits.overflow_policy == OverflowPolicy::Block and waitUntilDrained(block_until)))
+    {
+        ++dropped_msgs;
+        DEBUG_LOG << "Dropped message (size = " << size << ") for congested fd = " << fd;
+        return false;
+    }
+
+    const auto batching = limits.batch_bytes > 0;
+    Size written = 0;
+    if (entries.empty() and not batching)
+    {
+        // the common case - nothing ahead of this message, so it leaves without being queued
+        written = write(entry, 0, no_flags);
+        if (written == size)
+            return true;
+        front_offset = written;
+        setWaitingForWritable(true);
+    }
+
+    entries.push_back(move(entry));
+    queued_bytes += size - written;
+    // a full batch leaves at once, unless the socket is still busy with the previous one anyway
+    if (batching and queued_bytes >= limits.batch_bytes and not waiting_for_writable)
+        flushLocked();
+    if (queued_bytes >= limits.high_watermark and not overloaded)
+    {
+        overloaded = true;
+        WARN_LOG << "fd = " << fd << " is congested with " << queued_bytes << " bytes queued, "
+                 << (limits.overflow_policy == OverflowPolicy::Drop ? "dropping" : "blocking") << " new messages";
+    }
+    return true;
+}
+
+void SendQueue::flush()
+{
+    lock_guard<mutex> lock{mtx};
+    flushLocked();
+}
+
+void SendQueue::flushLocked()
+{
+    if (entries.empty())
+        return;
+
+    while (not entries.empty())
+    {
+        const auto more = entries.size() > 1 ? more_flag : no_flags;
+        const auto written = preserves_boundaries ? write(entries.front(), front_offset, more) : writeGathered();
+        if (not written)
+            break;
+        consume(written);
+    }
+
+    setWaitingForWritable(not entries.empty());
+    if (overloaded and queued_bytes <= limits.low_watermark)
+    {
+        overloaded = false;
+        INFO_LOG << "fd = " << fd << " drained to " << queued_bytes << " bytes queued";
+    }
+}
+
+Size SendQueue::write(const Entry& entry, Size offset, int flags)
+{
+    vector<iovec> iovecs;
+    appendIovecs(entry.pieces, offset, iovecs);
+    msghdr header{};
+    header.msg_iov = iovecs.data();
+    header.msg_iovlen = iovecs.size();
+    header.msg_control = const_cast<char*>(entry.control.data());
+    header.msg_controllen = entry.control.size();
+
+    // a reset peer must surface as EPIPE below, not as a SIGPIPE that takes the whole process down
+    const auto result = sendmsg(fd, &header, flags | MSG_NOSIGNAL);
+    if (result >= 0)
+        return result;
+    if (wouldBlock())
+        return 0;
+
+    // the connection is broken - the receive side notices and removes the peer, here the message is just gone
+    WARN_LOG << "Send failed on fd = " << fd << ": " << strerror(errno) << ", dropping " << entry.size - offset
+             << " bytes";
+    return entry.size - offset;
+}
+
+Size SendQueue::writeGathered()
+{
+    vector<iovec> iovecs;
+    auto offset = front_offset;
+    auto entry = entries.begin();
+    for (; entry != entries.end() and iovecs.size() < max_gathered_iovecs; ++entry)
+    {
+        appendIovecs(entry->pieces, offset, iovecs);
+        offset = 0;
+    }
+
+    msghdr header{};
+    header.msg_iov = iovecs.data();
+    header.msg_iovlen = iovecs.size();
+
+    // whatever did not fit into this write follows immediately, so the kernel should not push a partial segment
+    const auto result = sendmsg(fd, &header, (entry != entries.end() ? more_flag : no_flags) | MSG_NOSIGNAL);
+    if (result >= 0)
+        return result;
+    if (wouldBlock())
+        return 0;
+
+    WARN_LOG << "Send failed on fd = " << fd << ": " << strerror(errno) << ", dropping " << queued_bytes
+             << " queued bytes";
+    return queued_bytes;
+}
+
+void SendQueue::setWaitingForWritable(bool waiting)
+{
+    if (waiting != waiting_for_writable)
+        backlog_changed(waiting);
+    waiting_for_writable = waiting;
+}
+
+void SendQueue::consume(Size bytes)
+{
+    queued_bytes -= bytes;
+    bytes += front_offset;
+    while (not entries.empty() and bytes >= entries.front().size)
+    {
+        bytes -= entries.front().size;
+        entries.pop_front();
+    }
+    front_offset = bytes;
+}
+
+bool SendQueue::waitUntilDrained(optional<Deadline> block_until)
+{
+    // the sender does the flushing itself, so it depends on nothing but the socket
+    const auto deadline = block_until.value_or(chrono::steady_clock::now() + limits.block_timeout);
+    while (overloaded)
+    {
+        const auto remaining = chrono::duration_cast<Delay>(deadline - chrono::steady_clock::now());
+        pollfd writable{fd, POLLOUT, 0};
+        if (remaining.count() <= 0 or ::poll(&writable, 1, remaining.count()) <= 0)
+            return false;
+        flushLocked();
+    }
+    return true;
+}
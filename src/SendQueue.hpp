@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include "OverflowPolicy.hpp"
+#include "Typedefs.hpp"
+
+struct SendQueueLimits
+{
+    Size low_watermark = 256 * 1024;
+    Size high_watermark = 1024 * 1024;
+    OverflowPolicy overflow_policy = OverflowPolicy::Drop;
+    Delay block_timeout{1000};
+    Size batch_bytes{}; // when set, messages are held until this many bytes are queued or flush() is called
+};
+
+// Outbound data a non-blocking socket could not take yet. Messages go straight to the socket while nothing is queued
+// and only the unsent rest is kept. Stream sockets flush any number of queued messages with one gather write, whereas
+// message sockets send every message whole together with its own ancillary data.
+// In batching mode nothing is written before a batch is full or flushed explicitly, and the batch then leaves in as few
+// packets as possible - every write but the last carries MSG_MORE, so the kernel keeps the socket corked in between.
+// Once the queue grows past the high watermark new messages are dropped, or the sender waits for the socket itself,
+// until it drains below the low watermark. A fan-out passes one deadline to all of its queues, so that it waits for
+// block_timeout at most in total rather than for every congested peer in turn.
+class SendQueue
+{
+public:
+    using Pieces = std::vector<SharedChatMessage>;
+    using PreservesBoundaries = bool;
+    using SupportsMsgMore = bool;
+    using BacklogChanged = std::function<void(bool pending)>; // start or stop watching for writability
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    SendQueue(FD, PreservesBoundaries, SupportsMsgMore, const SendQueueLimits&, BacklogChanged);
+    ~SendQueue();
+
+    // the pieces form one message, which is sent or dropped as a whole; returns false when it was dropped
+    bool send(Pieces, ControlBuffer = {}, std::optional<Deadline> block_until = {});
+    void flush();
+
+private:
+    struct Entry
+    {
+        Pieces pieces;
+        ControlBuffer control;
+        Size size;
+    };
+
+    void flushLocked();
+    Size write(const Entry&, Size offset, int flags);
+    Size writeGathered();
+    void setWaitingForWritable(bool);
+    void consume(Size bytes);
+    bool waitUntilDrained(std::optional<Deadline>);
+
+    FD fd;
+    PreservesBoundaries preserves_boundaries;
+    int more_flag;
+    SendQueueLimits limits;
+    BacklogChanged backlog_changed;
+
+    std::deque<Entry> entries;
+    Size front_offset{};
+    Size queued_bytes{};
+    bool overloaded = false;
+    bool waiting_for_writable = false;
+    Size dropped_msgs{};
+    std::mutex mtx;
+};
@@ -1,11 +1,10 @@
 #include "Socket.hpp"
-#include <tools/AsyncTask.hpp>
 #include <tools/ContainerOperators.hpp>
 #include <tools/Contains.hpp>
-#include <tools/TaskScheduler.hpp>
 #include "SocketConfiguration.hpp"
 #include "SocketErrorChecks.hpp"
 #include "SocketIO.hpp"
+#include "TimerWheel.hpp"
 
 using namespace std;
 
@@ -15,7 +14,7 @@ static auto chooseSocketFamily(const LocalIPSockets& locals)
 }
 
 Socket::Socket(const LocalIPSockets& locals,
-               TaskScheduler& ts,
+               TimerWheel& ts,
                Type type,
                Protocol protocol,
                Family fam,
@@ -26,9 +25,23 @@ Socket::Socket(const LocalIPSockets& locals,
     {
         fd = FileDescriptor{checkedSocket(socket(family, type, protocol))};
         DEBUG_LOG << "Created socket: fd = " << fd << ", family = " << toString(family);
+        watch(fd);
     }
 }
 
+void Socket::useIoUring()
+{
+    INFO_LOG << "Switching fd = " << fd << " to io_uring";
+    epoll.remove(fd);
+    uring = make_unique<IoUring>(peer_msg_buffers);
+    watch(fd);
+}
+
+void Socket::handleOnCallingThread()
+{
+    handle_on_calling_thread = true;
+}
+
 void Socket::listen(BacklogCount backlog_count)
 {
     if (shouldListen())
@@ -45,16 +58,67 @@ void Socket::connectMultihomed(const RemoteIPSockets&)
     WARN_LOG << "Impossible on this socket type";
 }
 
-void Socket::receive()
+void Socket::addLocalAddress(const IP&)
+{
+    WARN_LOG << "Impossible on this socket type";
+}
+
+void Socket::removeLocalAddress(const IP&)
+{
+    WARN_LOG << "Impossible on this socket type";
+}
+
+void Socket::sendPartiallyReliable(const ChatMessage&, const PrInfo&)
+{
+    WARN_LOG << "Impossible on this socket type";
+}
+
+void Socket::receive(Timeout timeout)
 {
-    using namespace RangeOperators;
-    AsyncTasks tasks;
-    for (auto fd : selectFds())
+    if (uring)
+    {
+        const auto completions = uring->wait(timeout);
+        countLoad(completions.size());
+        for (const auto& completion : completions)
+            handleCompletion(completion);
+        return;
+    }
+
+    const auto fds = selectFds(timeout);
+    countLoad(fds.size());
+    if (handle_on_calling_thread)
+    {
+        for (auto fd : fds)
+            handleMessage(fd);
+        for (auto fd : epoll.writableFds())
+            handleWritable(fd);
+        return;
+    }
+
+    // created lazily so that no threads exist yet when SocketUnixForked forks
+    if (not workers)
+        workers = make_unique<WorkerPool>();
+
+    // each fd is dispatched at most once per wait and always to the same worker, so its messages stay in order
+    for (auto fd : fds)
     {
         DEBUG_LOG << "Receiving message on fd = " << fd;
-        tasks += asyncTask(&Socket::handleMessage, this, fd);
+        workers->dispatch(fd, [this, fd] { handleMessage(fd); });
     }
-    join(tasks);
+    for (auto fd : epoll.writableFds())
+        handleWritable(fd);
+    workers->wait();
+}
+
+void Socket::flush()
+{
+    if (uring)
+        uring->submit();
+}
+
+FD Socket::pollFd() const
+{
+    return uring ? FD{*uring} : FD{epoll};
 }
 
 void Socket::configure(FD fd)
@@ -96,13 +160,18 @@ RemoteIPSockets Socket::getPeerAddresses(FD fd) const
     return getAddresses(fd, getpeername);
 }
 
-FDs Socket::selectFds()
+FDs Socket::selectFds(Timeout timeout)
+{
+    return epoll.wait(timeout);
+}
+
+void Socket::handleCompletion(const IoUring::Completion& completion)
 {
-    fd_set.reset();
-    fd_set.set(fd);
-    return fd_set.select();
+    completion.writable ? handleWritable(completion.fd) : handleMessage(completion.fd);
 }
 
+void Socket::handleWritable(FD) {}
+
 IOBuffer& Socket::getBuffer(FD)
 {
     return *main_msg_buffer;
@@ -120,16 +189,24 @@ void Socket::connect(FD fd, const RemoteIPSocket& remote)
     checkConnect(::connect(fd, asSockaddrPtr(saddr), remote.sizeofSockaddr()));
 }
 
-pair<FileDescriptor, RemoteIPSocket> Socket::accept()
+optional<pair<FileDescriptor, RemoteIPSocket>> Socket::tryAccept()
 {
-    DEBUG_LOG << "Accepting: fd = " << fd;
     sockaddr_storage saddr_storage{};
-    socklen_t saddr_len = sizeof(sockaddr_storage);
-    FileDescriptor accept_result{
-        checkedAccept(accept4(fd, asSockaddrPtr(saddr_storage), &saddr_len, SOCK_NONBLOCK | SOCK_CLOEXEC))};
+    socklen_t saddr_len;
+    int result;
+    // a connection reset while still in the backlog is gone already, the next one may be fine
+    do
+    {
+        saddr_len = sizeof(sockaddr_storage);
+        result = accept4(fd, asSockaddrPtr(saddr_storage), &saddr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    } while (result < 0 and errno == ECONNABORTED);
+    if (result < 0 and in(errno, {EAGAIN, EWOULDBLOCK}))
+        return {};
+
+    FileDescriptor accept_result{checkedAccept(result)};
     const auto remote = RemoteIPSocket{saddr_storage};
     DEBUG_LOG << "Accepted remote fd = " << accept_result << ", peer address = " << remote;
-    return {move(accept_result), remote};
+    return pair{move(accept_result), remote};
 }
 
 void Socket::scheduleReestablishment(const RemoteIPSocket& remote)
@@ -137,3 +214,50 @@ void Socket::scheduleReestablishment(const RemoteIPSocket& remote)
     DEBUG_LOG << "Scheduled delayed reestablishment to remote " << remote;
     task_scheduler.schedule([=, this] { connect({remote}); }, 5s);
 }
+
+void Socket::watch(FD fd)
+{
+    uring ? uring->poll(fd) : epoll.add(fd);
+}
+
+void Socket::watchStream(FD fd)
+{
+    uring ? uring->receive(fd) : epoll.add(fd);
+}
+
+void Socket::watchWritable(FD fd)
+{
+    // one-shot, so a connect in progress is reported once even while the workers are still busy with it
+    uring ? uring->pollWritable(fd) : epoll.add(fd, EPOLLOUT | EPOLLONESHOT);
+}
+
+shared_ptr<SendQueue> Socket::createSendQueue(FD fd,
+                                              SendQueue::PreservesBoundaries preserves_boundaries,
+                                              SendQueue::SupportsMsgMore supports_msg_more,
+                                              const SendQueueLimits& limits)
+{
+    if (uring)
+        return {};
+    return make_shared<SendQueue>(fd, preserves_boundaries, supports_msg_more, limits, [this, fd](bool pending) {
+        // flushed on the network thread as soon as the socket takes data again
+        epoll.modify(fd, pending ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    });
+}
+
+void Socket::unwatch(FD fd)
+{
+    uring ? uring->cancel(fd) : epoll.remove(fd);
+}
+
+void Socket::countLoad(Size events)
+{
+    if (not events)
+        return;
+    ++load.wakeups;
+    load.events += events;
+}
+
+Size Socket::watchedFdCount() const
+{
+    return uring ? uring->watchedFdCount() : epoll.watchedFdCount();
+}
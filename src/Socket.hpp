@@ -1,10 +1,14 @@
 #pragma once
 
+#include <optional>
 #include <tools/BufferPool.hpp>
-#include "FDSet.hpp"
-#include "FileDescriptor.hpp"
+#include "Epoll.hpp"
+#include "IoUring.hpp"
+#include "PrPolicy.hpp"
+#include "SendQueue.hpp"
+#include "WorkerPool.hpp"
 
-class TaskScheduler;
+class TimerWheel;
 
 using BacklogCount = int;
 
@@ -13,6 +17,9 @@ constexpr auto ignore_flags = 0;
 
 class Socket
 {
+public:
+    using Timeout = std::chrono::milliseconds;
+
 protected:
     using Type = int;
     using Protocol = int;
@@ -23,42 +30,74 @@ public:
     virtual ~Socket() {}
 
     Socket(const LocalIPSockets&,
-           TaskScheduler&,
+           TimerWheel&,
            Type,
            Protocol = default_protocol,
            Family = AF_UNSPEC,
            DeferCreation = false);
 
+    virtual void useIoUring();
+    void handleOnCallingThread();
     void listen(BacklogCount);
     virtual void connect(const RemoteIPSockets&);
     virtual void connectMultihomed(const RemoteIPSockets&);
-    virtual void receive();
+    virtual void addLocalAddress(const IP&);
+    virtual void removeLocalAddress(const IP&);
+    virtual void receive(Timeout = Timeout{100});
+    void flush();
+    FD pollFd() const;
     virtual void send(const ChatMessage&) = 0;
+    virtual void sendPartiallyReliable(const ChatMessage&, const PrInfo&);
 
 protected:
     virtual void configure(FD);
     virtual void bind(FD, const LocalIPSockets&);
     virtual LocalIPSockets getBoundAddresses(FD) const;
     virtual RemoteIPSockets getPeerAddresses(FD) const;
-    virtual FDs selectFds();
+    virtual FDs selectFds(Timeout);
     virtual void handleMessage(FD) = 0;
+    virtual void handleCompletion(const IoUring::Completion&);
+    virtual void handleWritable(FD);
     virtual IOBuffer& getBuffer(FD);
 
     bool shouldListen() const;
     void connect(FD, const RemoteIPSocket&);
-    std::pair<FileDescriptor, RemoteIPSocket> accept();
+    std::optional<std::pair<FileDescriptor, RemoteIPSocket>> tryAccept(); // empty once the backlog is drained
     void scheduleReestablishment(const RemoteIPSocket&);
+    void watch(FD);
+    void watchStream(FD);
+    void watchWritable(FD);
+    // sends through io_uring are queued by the kernel, so a queue is only there for the synchronous backends
+    std::shared_ptr<SendQueue> createSendQueue(FD,
+                                               SendQueue::PreservesBoundaries,
+                                               SendQueue::SupportsMsgMore,
+                                               const SendQueueLimits&);
+    void unwatch(FD);
+
+    // receive calls that found something to do and the fds or completions they handled, reset by whoever reports them
+    struct LoadCounters
+    {
+        Size wakeups{};
+        Size events{};
+    };
+    void countLoad(Size events);
+    Size watchedFdCount() const;
+    LoadCounters load;
 
     FileDescriptor fd;
     Family family;
     Type type;
 
-    FDSet fd_set;
+    Epoll epoll;
 
     BufferPool<IOBuffer> peer_msg_buffers{64 * 1024};
     BufferPtr main_msg_buffer = peer_msg_buffers.get();
 
-    TaskScheduler& task_scheduler;
+    std::unique_ptr<IoUring> uring;
+    std::unique_ptr<WorkerPool> workers;
+    bool handle_on_calling_thread = false;
+
+    TimerWheel& task_scheduler;
 };
 
 template <class T>
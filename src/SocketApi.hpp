@@ -6,6 +6,7 @@
 #include <netinet/in.h>
 #include <netinet/sctp.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
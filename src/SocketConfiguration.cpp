@@ -1,8 +1,12 @@
 #include "SocketConfiguration.hpp"
+#include <linux/filter.h>
+#include "FileDescriptor.hpp"
 
 namespace
 {
     constexpr auto yes = 1;
+    constexpr auto full_interleave = 2;
+    constexpr auto pf_expose_enable = 2; // SCTP_PF_EXPOSE_ENABLE, missing from older uapi headers
 
 #define SETSOCKOPT(Protocol, Option, Value) checkSetsockopt(setsockopt(fd, Protocol, Option, &Value, sizeof(Value)))
 #define SETSOCKOPT_SCTP(Option, Value) SETSOCKOPT(IPPROTO_SCTP, Option, Value)
@@ -11,6 +15,7 @@ namespace
 #define SETSOCKOPT_IPV6(Option, Value) SETSOCKOPT(IPPROTO_IPV6, Option, Value)
 #define SETSOCKOPT_SOL_SCTP(Option, Value) SETSOCKOPT(SOL_SCTP, Option, Value)
 #define SETSOCKOPT_SOL_TCP(Option, Value) SETSOCKOPT(SOL_TCP, Option, Value)
+#define SETSOCKOPT_SOL_UDP(Option, Value) SETSOCKOPT(SOL_UDP, Option, Value)
 } // namespace
 
 void configureNoDelay(FD fd)
@@ -18,11 +23,34 @@ void configureNoDelay(FD fd)
     SETSOCKOPT_SCTP(SCTP_NODELAY, yes);
 }
 
+void configureTcpNoDelay(FD fd)
+{
+    SETSOCKOPT_SOL_TCP(TCP_NODELAY, yes);
+}
+
 void configureReuseAddr(FD fd)
 {
     SETSOCKOPT_SOL(SO_REUSEADDR, yes);
 }
 
+void configureReusePort(FD fd)
+{
+    SETSOCKOPT_SOL(SO_REUSEPORT, yes);
+}
+
+void configureReusePortCpuSteering(FD fd, Size group_size)
+{
+    // picks the socket cpu % group_size of the SO_REUSEPORT group - the shard pinned to the receiving core only when
+    // there is one shard per core, otherwise cores just share shards round robin
+    sock_filter code[] = {{BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<u32>(SKF_AD_OFF + SKF_AD_CPU)},
+                          {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<u32>(group_size)},
+                          {BPF_RET | BPF_A, 0, 0, 0}};
+    sock_fprog program{};
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+    SETSOCKOPT_SOL(SO_ATTACH_REUSEPORT_CBPF, program);
+}
+
 void configureReceivingEvents(FD fd)
 {
     sctp_event_subscribe subscribe{};
@@ -37,9 +65,16 @@ void configureReceivingEvents(FD fd)
     SETSOCKOPT_SCTP(SCTP_EVENTS, subscribe);
 }
 
-void configureInitParams(FD fd, InitMaxAttempts init_max_attempts, InitMaxTimeoutInMs init_max_timeout)
+void configureInitParams(FD fd,
+                         InitMaxAttempts init_max_attempts,
+                         InitMaxTimeoutInMs init_max_timeout,
+                         OutStreams out_streams,
+                         MaxInStreams max_in_streams)
 {
+    // zero stream counts leave the kernel defaults in place
     sctp_initmsg init_msg{};
+    init_msg.sinit_num_ostreams = out_streams;
+    init_msg.sinit_max_instreams = max_in_streams;
     init_msg.sinit_max_attempts = init_max_attempts;
     init_msg.sinit_max_init_timeo = init_max_timeout;
     SETSOCKOPT_SCTP(SCTP_INITMSG, init_msg);
@@ -110,6 +145,109 @@ void configureMaxSeg(FD fd, SocketParam max_seg, AssocId assoc)
     SETSOCKOPT_SCTP(SCTP_MAXSEG, assoc_val);
 }
 
+void configurePartialDeliveryPoint(FD fd, SocketParam bytes)
+{
+    const u32 point = bytes;
+    SETSOCKOPT_SCTP(SCTP_PARTIAL_DELIVERY_POINT, point);
+}
+
+void configureFragmentInterleave(FD fd, SocketParam level)
+{
+    // 0 - one partial delivery blocks the whole socket, 1 - blocks only its association, 2 - only its stream
+    SETSOCKOPT_SCTP(SCTP_FRAGMENT_INTERLEAVE, level);
+}
+
+void configureInterleaving(FD fd)
+{
+    // RFC 8260 I-DATA - needs net.sctp.intl_enable and a fragment interleave level of 2
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = all_associations;
+    assoc_val.assoc_value = yes;
+    SETSOCKOPT_SCTP(SCTP_INTERLEAVING_SUPPORTED, assoc_val);
+}
+
+bool supportsSctpInterleaving()
+{
+    // EPERM while net.sctp.intl_enable is off, so probe once instead of failing every socket later
+    FileDescriptor probe{checkedSocket(socket(AF_INET, SOCK_SEQPACKET, IPPROTO_SCTP))};
+    setsockopt(probe, IPPROTO_SCTP, SCTP_FRAGMENT_INTERLEAVE, &full_interleave, sizeof(full_interleave));
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = all_associations;
+    assoc_val.assoc_value = yes;
+    return setsockopt(probe, IPPROTO_SCTP, SCTP_INTERLEAVING_SUPPORTED, &assoc_val, sizeof(assoc_val)) == 0;
+}
+
+void configureStreamScheduler(FD fd, SocketParam scheduler, AssocId assoc)
+{
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = assoc;
+    assoc_val.assoc_value = scheduler;
+    SETSOCKOPT_SCTP(SCTP_STREAM_SCHEDULER, assoc_val);
+}
+
+void configureStreamPriority(FD fd, StreamId stream, SocketParam priority, AssocId assoc)
+{
+    sctp_stream_value stream_val{};
+    stream_val.assoc_id = assoc;
+    stream_val.stream_id = stream;
+    stream_val.stream_value = priority;
+    SETSOCKOPT_SCTP(SCTP_STREAM_SCHEDULER_VALUE, stream_val);
+}
+
+void configurePotentiallyFailedThreshold(
+    FD fd, PathMaxRetrans path_max_retrans, PfThreshold pf_threshold, AssocId assoc)
+{
+    // a wildcard address applies the thresholds to every path of the association
+    sctp_paddrthlds thresholds{};
+    thresholds.spt_assoc_id = assoc;
+    thresholds.spt_pathmaxrxt = path_max_retrans;
+    thresholds.spt_pathpfthld = pf_threshold;
+    SETSOCKOPT_SCTP(SCTP_PEER_ADDR_THLDS, thresholds);
+}
+
+void configureExposePotentiallyFailedState(FD fd, AssocId assoc)
+{
+    // without it the kernel may report potentially failed paths as active, depending on net.sctp.pf_expose
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = assoc;
+    assoc_val.assoc_value = pf_expose_enable;
+    SETSOCKOPT_SCTP(SCTP_EXPOSE_POTENTIALLY_FAILED_STATE, assoc_val);
+}
+
+void configurePrimaryAddress(FD fd, const sockaddr_storage& address, AssocId assoc)
+{
+    sctp_prim prim{};
+    prim.ssp_assoc_id = assoc;
+    prim.ssp_addr = address;
+    SETSOCKOPT_SCTP(SCTP_PRIMARY_ADDR, prim);
+}
+
+void configureAsconf(FD fd)
+{
+    // the peer only accepts ASCONF chunks when net.sctp.addip_enable and net.sctp.auth_enable are set on both sides
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = all_associations;
+    assoc_val.assoc_value = yes;
+    SETSOCKOPT_SCTP(SCTP_ASCONF_SUPPORTED, assoc_val);
+}
+
+void configurePrSupported(FD fd)
+{
+    sctp_assoc_value assoc_val{};
+    assoc_val.assoc_id = all_associations;
+    assoc_val.assoc_value = yes;
+    SETSOCKOPT_SCTP(SCTP_PR_SUPPORTED, assoc_val);
+}
+
+void configureDefaultPrInfo(FD fd, SocketParam policy, SocketParam value, AssocId assoc)
+{
+    sctp_default_prinfo pr_info{};
+    pr_info.pr_assoc_id = assoc;
+    pr_info.pr_policy = policy;
+    pr_info.pr_value = value;
+    SETSOCKOPT_SCTP(SCTP_DEFAULT_PRINFO, pr_info);
+}
+
 void configureNonBlockingMode(FD fd)
 {
     int flags = 0;
@@ -130,3 +268,13 @@ void configurePassCred(FD fd)
 {
     SETSOCKOPT_SOL(SO_PASSCRED, yes);
 }
+
+void configureUdpSegment(FD fd, SocketParam gso_size)
+{
+    SETSOCKOPT_SOL_UDP(UDP_SEGMENT, gso_size);
+}
+
+void configureUdpGro(FD fd)
+{
+    SETSOCKOPT_SOL_UDP(UDP_GRO, yes);
+}
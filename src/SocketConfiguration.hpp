@@ -6,6 +6,8 @@
 
 using InitMaxAttempts = SocketParam;
 using InitMaxTimeoutInMs = SocketParam;
+using OutStreams = SocketParam;
+using MaxInStreams = SocketParam;
 using RtoInitialInMs = SocketParam;
 using RtoMinInMs = SocketParam;
 using RtoMaxInMs = SocketParam;
@@ -14,16 +16,23 @@ using SackDelay = SocketParam;
 using HbInterval = SocketParam;
 using PathMaxRetrans = SocketParam;
 using PathMtu = SocketParam;
+using PfThreshold = SocketParam;
 using KeepAliveTimeInS = SocketParam;
 using KeepAliveIntervalInS = SocketParam;
 using KeepAliveProbes = SocketParam;
 
 constexpr auto all_associations = ignore_assoc;
+// shared by the socket defaults, SctpTuner and SctpPathManager - the pf threshold has to stay below this one
+constexpr PathMaxRetrans sctp_path_max_retrans = 3;
+constexpr SackFreq sctp_sack_freq = 2;
 
 void configureNoDelay(FD);
+void configureTcpNoDelay(FD);
 void configureReuseAddr(FD);
+void configureReusePort(FD);
+void configureReusePortCpuSteering(FD, Size group_size);
 void configureReceivingEvents(FD);
-void configureInitParams(FD, InitMaxAttempts, InitMaxTimeoutInMs);
+void configureInitParams(FD, InitMaxAttempts, InitMaxTimeoutInMs, OutStreams = {}, MaxInStreams = {});
 void configureRto(FD, RtoInitialInMs, RtoMinInMs, RtoMaxInMs, AssocId = all_associations);
 void configureSack(FD, SackFreq, SackDelay, AssocId = all_associations);
 void configureMaxRetrans(FD, SocketParam, AssocId = all_associations);
@@ -32,9 +41,23 @@ void configureIPv4AddressMapping(FD);
 void configureTTL(FD, SocketParam);
 void configurePeerAddressParams(FD, HbInterval, PathMaxRetrans, PathMtu, AssocId = all_associations);
 void configureMaxSeg(FD, SocketParam, AssocId = all_associations);
+void configurePartialDeliveryPoint(FD, SocketParam);
+void configureFragmentInterleave(FD, SocketParam);
+void configureInterleaving(FD);
+bool supportsSctpInterleaving();
+void configureStreamScheduler(FD, SocketParam scheduler, AssocId = all_associations);
+void configureStreamPriority(FD, StreamId, SocketParam priority, AssocId);
+void configurePotentiallyFailedThreshold(FD, PathMaxRetrans, PfThreshold, AssocId = all_associations);
+void configureExposePotentiallyFailedState(FD, AssocId = all_associations);
+void configurePrimaryAddress(FD, const sockaddr_storage&, AssocId);
+void configureAsconf(FD);
+void configurePrSupported(FD);
+void configureDefaultPrInfo(FD, SocketParam policy, SocketParam value, AssocId = all_associations);
 void configureNonBlockingMode(FD);
 void configureKeepAlive(FD, KeepAliveTimeInS, KeepAliveIntervalInS, KeepAliveProbes);
 void configurePassCred(FD);
+void configureUdpSegment(FD, SocketParam);
+void configureUdpGro(FD);
 
 template <class ValueContainer>
 void optInfo(FD fd, int option, ValueContainer& value_container, AssocId assoc_id = ignore_assoc)
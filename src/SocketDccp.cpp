@@ -1,10 +1,13 @@
 #include "SocketDccp.hpp"
+#include <algorithm>
+#include <chrono>
 #include <tools/ThreadSafeLogger.hpp>
 #include "Constants.hpp"
+#include "NetworkConfiguration.hpp"
 
 using namespace std;
 
-SocketDccp::SocketDccp(const LocalIPSockets& locals, TaskScheduler& ts) : SocketTcp(locals, ts, SOCK_DCCP) {}
+SocketDccp::SocketDccp(const NetworkConfiguration& config, TimerWheel& ts) : SocketTcp(config, ts, SOCK_DCCP) {}
 
 SocketDccp::~SocketDccp()
 {
@@ -13,11 +16,13 @@ SocketDccp::~SocketDccp()
 
 void SocketDccp::send(const ChatMessage& msg)
 {
+    const auto framed = frame(msg);
     LOCK_MTX(peers_mtx);
+    const auto block_until = chrono::steady_clock::now() + config.send_queue_limits.block_timeout;
     for (const auto& p : peers)
         try
         {
-            sendMessage(msg, p.second);
+            sendMessage(framed, p.second, block_until);
         }
         catch (const runtime_error& ex)
         {
@@ -29,15 +34,22 @@ void SocketDccp::handleMessage(FD fd)
 {
     if (fd == this->fd)
         return handleCommUp();
+    if (auto pending = takePendingConnect(fd))
+        return handleConnectCompletion(move(*pending));
 
-    receiveMessage(fd);
-    const ChatMessage msg{getBuffer(fd).data()};
-
-    if (msg.empty())
-        return handleCommLost(fd);
+    handleData(fd, receiveMessage(fd));
+}
 
-    if (msg == quit_msg)
-        return handleGracefulShutdown(fd);
+void SocketDccp::handleReceived(FD fd, const FrameParser::Frames& frames)
+{
+    const auto quit = find(frames.begin(), frames.end(), quit_msg);
+    if (quit != frames.begin())
+        SocketTcp::handleReceived(fd, {frames.begin(), quit});
+    if (quit != frames.end())
+        handleGracefulShutdown(fd);
+}
 
-    INFO_LOG << "Received message: " << msg << " (size = " << msg.size() << ") from " << getPeerAddresses(fd);
+void SocketDccp::handleEndOfStream(FD fd)
+{
+    handleCommLost(fd);
 }
@@ -5,11 +5,13 @@
 class SocketDccp : public SocketTcp
 {
 public:
-    SocketDccp(const LocalIPSockets&, TaskScheduler&);
+    SocketDccp(const NetworkConfiguration&, TimerWheel&);
     ~SocketDccp();
 
     void send(const ChatMessage&) override;
 
 private:
     void handleMessage(FD) override;
+    void handleReceived(FD, const FrameParser::Frames&) override;
+    void handleEndOfStream(FD) override;
 };
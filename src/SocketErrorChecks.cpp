@@ -18,6 +18,26 @@ bool failedConnect(int result)
     return not(result == 0 or in(errno, {EINPROGRESS, EINTR}));
 }
 
+bool failedEpollCreate(int result)
+{
+    return result < 0;
+}
+
+bool failedEpollCtl(int result)
+{
+    return result != 0;
+}
+
+bool failedEpollWait(int result)
+{
+    return result < 0;
+}
+
+bool failedEventfd(int result)
+{
+    return result < 0;
+}
+
 bool failedFcntl(int result)
 {
     return result == -1;
@@ -53,6 +73,16 @@ bool failedInetpton(int result)
     return result != 1;
 }
 
+bool failedIoUring(int result)
+{
+    return result < 0;
+}
+
+bool failedIoUringWait(int result)
+{
+    return result < 0 and not in(-result, {ETIME, EINTR});
+}
+
 bool failedListen(int result)
 {
     return result != 0;
@@ -158,11 +188,21 @@ bool failedSend(int result)
     return result < 0;
 }
 
+bool failedSetaffinity(int result)
+{
+    return result != 0;
+}
+
 bool failedSetsockopt(int result)
 {
     return result != 0;
 }
 
+bool failedSettime(int result)
+{
+    return result != 0;
+}
+
 bool failedShmdt(int result)
 {
     return result != 0;
@@ -188,6 +228,11 @@ bool failedSocketpair(int result)
     return result != 0;
 }
 
+bool failedTimerfd(int result)
+{
+    return result < 0;
+}
+
 bool failedTruncate(int result)
 {
     return result != 0;
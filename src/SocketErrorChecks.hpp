@@ -12,6 +12,10 @@
 GENERATE_SOCKET_CHECK_INT(Accept)
 GENERATE_SOCKET_CHECK_INT(Bind)
 GENERATE_SOCKET_CHECK_INT(Connect)
+GENERATE_SOCKET_CHECK_INT(EpollCreate)
+GENERATE_SOCKET_CHECK_INT(EpollCtl)
+GENERATE_SOCKET_CHECK_INT(EpollWait)
+GENERATE_SOCKET_CHECK_INT(Eventfd)
 GENERATE_SOCKET_CHECK_INT(Fcntl)
 GENERATE_SOCKET_CHECK_INT(Fork)
 GENERATE_SOCKET_CHECK_INT(Getaddrs)
@@ -19,6 +23,8 @@ GENERATE_SOCKET_CHECK_INT(Getpeername)
 GENERATE_SOCKET_CHECK_INT(Getsockname)
 GENERATE_SOCKET_CHECK_INT(Getsockopt)
 GENERATE_SOCKET_CHECK_INT(Inetpton)
+GENERATE_SOCKET_CHECK_INT(IoUring)
+GENERATE_SOCKET_CHECK_INT(IoUringWait)
 GENERATE_SOCKET_CHECK_INT(Listen)
 GENERATE_SOCKET_CHECK_INT(Mkfifo)
 GENERATE_SOCKET_CHECK_INT(MqClose)
@@ -40,12 +46,15 @@ GENERATE_SOCKET_CHECK_INT(Seminit)
 GENERATE_SOCKET_CHECK_INT(Sempost)
 GENERATE_SOCKET_CHECK_INT(Semtrywait)
 GENERATE_SOCKET_CHECK_INT(Send)
+GENERATE_SOCKET_CHECK_INT(Setaffinity)
 GENERATE_SOCKET_CHECK_INT(Setsockopt)
+GENERATE_SOCKET_CHECK_INT(Settime)
 GENERATE_SOCKET_CHECK_INT(Shmdt)
 GENERATE_SOCKET_CHECK_INT(Shmget)
 GENERATE_SOCKET_CHECK_INT(Shmopen)
 GENERATE_SOCKET_CHECK_INT(Socket)
 GENERATE_SOCKET_CHECK_INT(Socketpair)
+GENERATE_SOCKET_CHECK_INT(Timerfd)
 GENERATE_SOCKET_CHECK_INT(Truncate)
 GENERATE_SOCKET_CHECK_INT(Write)
 GENERATE_SOCKET_CHECK_INT(WsaStartup)
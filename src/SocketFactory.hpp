@@ -4,5 +4,5 @@
 #include "NetworkConfiguration.hpp"
 
 class Socket;
-class TaskScheduler;
-std::unique_ptr<Socket> createSocket(const NetworkConfiguration&, TaskScheduler&);
+class TimerWheel;
+std::unique_ptr<Socket> createSocket(const NetworkConfiguration&, TimerWheel&);
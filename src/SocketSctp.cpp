@@ -1,4 +1,5 @@
 #include "SocketSctp.hpp"
+#include <cstring>
 #include <tools/RangeStlAlgorithms.hpp>
 #include "NetworkConfiguration.hpp"
 #include "SctpGetAddrs.hpp"
@@ -8,12 +9,136 @@
 
 using namespace std;
 
-SocketSctp::SocketSctp(const NetworkConfiguration& cfg, TaskScheduler& ts)
-    : Socket(cfg.locals, ts, SOCK_SEQPACKET), config(cfg)
+namespace
+{
+    constexpr auto full_interleave = 2;
+    constexpr auto pr_status_period = 10s;
+    constexpr auto tune_period = 1s;
+    constexpr auto path_check_period = 1s;
+    constexpr auto forever = numeric_limits<TimerWheel::Repetitions>::max();
+    constexpr auto sctp_ss_fc = SCTP_SS_RR + 1; // SCTP_SS_FC, missing from older uapi headers
+    constexpr Size max_reassembly_bytes = 16 * 1024 * 1024; // per association, over all of its streams
+
+    SocketParam toSctpScheduler(StreamScheduler scheduler)
+    {
+        switch (scheduler)
+        {
+            case StreamScheduler::Priority: return SCTP_SS_PRIO;
+            case StreamScheduler::RoundRobin: return SCTP_SS_RR;
+            case StreamScheduler::FairCapacity: return sctp_ss_fc;
+            default: return SCTP_SS_FCFS;
+        }
+    }
+
+    SocketParam toSctpPrPolicy(PrPolicy policy)
+    {
+        switch (policy)
+        {
+            case PrPolicy::Ttl: return SCTP_PR_SCTP_TTL;
+            case PrPolicy::Rtx: return SCTP_PR_SCTP_RTX;
+            case PrPolicy::Prio: return SCTP_PR_SCTP_PRIO;
+            default: return SCTP_PR_SCTP_NONE;
+        }
+    }
+
+    auto usesPrSctp(const NetworkConfiguration& config)
+    {
+        return config.default_pr_info.policy != PrPolicy::None or not config.stream_pr_infos.empty();
+    }
+
+    auto usesInterleaving(const NetworkConfiguration& config)
+    {
+        if (not config.interleaving or supportsSctpInterleaving())
+            return config.interleaving;
+
+        WARN_LOG << "I-DATA interleaving is not permitted (is net.sctp.intl_enable off?) - continuing without it";
+        return false;
+    }
+} // namespace
+
+SocketSctp::SocketSctp(const NetworkConfiguration& cfg, TimerWheel& ts)
+    : Socket(cfg.locals, ts, SOCK_SEQPACKET), select_stream(createStreamSelector(cfg.stream_policy)), config(cfg),
+      interleaving(usesInterleaving(cfg))
 {
     SocketSctp::configure(fd);
     DEBUG_LOG << "Configured fd = " << fd;
     SocketSctp::bind(fd, config.locals);
+    send_queues[fd] = createSendQueue(
+        fd, SendQueue::PreservesBoundaries{true}, SendQueue::SupportsMsgMore{true}, config.send_queue_limits);
+
+    // built once and shared by every send and every peer
+    if (config.big_msg_size)
+        big_msg = make_shared<const ChatMessage>(config.big_msg_size, 'x');
+
+    if (usesPrSctp(config))
+        pr_status_task = task_scheduler.schedule([this] { logAbandoned(); }, pr_status_period, forever);
+
+    if (config.tune)
+    {
+        tuner.emplace(config.tuning_bounds, config.path_mtu);
+        tune_task = task_scheduler.schedule([this] { tuneAssociations(); }, tune_period, forever);
+    }
+
+    if (config.manage_paths)
+    {
+        path_manager.emplace(config.pf_threshold);
+        path_task = task_scheduler.schedule([this] { evaluatePaths(); }, path_check_period, forever);
+    }
+
+    if (config.stats_period.count())
+    {
+        stats = make_unique<SctpStatsSampler>(config.stats_file, config.stats_endpoint);
+        if (not config.stats_endpoint.empty())
+            watch(stats->endpoint());
+        stats_task = task_scheduler.schedule([this] { sampleStats(); }, config.stats_period, forever);
+    }
+
+    if (config.batch_delay.count())
+        batch_task = task_scheduler.schedule([this] { flushBatches(); }, config.batch_delay, forever);
+
+    if (config.load_report_period.count())
+        load_task = task_scheduler.schedule([this] { reportLoad(); }, config.load_report_period, forever);
+}
+
+SocketSctp::~SocketSctp()
+{
+    if (auto task = pr_status_task.lock())
+    {
+        task->disable();
+        logAbandoned();
+    }
+    if (auto task = tune_task.lock())
+        task->disable();
+    if (auto task = path_task.lock())
+        task->disable();
+    if (auto task = stats_task.lock())
+        task->disable();
+    if (auto task = batch_task.lock())
+        task->disable();
+    if (auto task = load_task.lock())
+        task->disable();
+
+    for (const auto& [stream, counters] : stream_counters)
+        INFO_LOG << "Stream " << stream << ": sent " << counters.sent_msgs << " messages (" << counters.sent_bytes
+                 << " bytes), received " << counters.received_msgs << " messages (" << counters.received_bytes
+                 << " bytes)";
+}
+
+void SocketSctp::useIoUring()
+{
+    // the stats endpoint is watched next to the main fd, so it has to move over to the ring as well
+    const auto has_endpoint = stats and not config.stats_endpoint.empty();
+    if (has_endpoint)
+        unwatch(stats->endpoint());
+    Socket::useIoUring();
+    if (has_endpoint)
+        watch(stats->endpoint());
+}
+
+void SocketSctp::receive(Timeout timeout)
+{
+    Socket::receive(timeout);
+    releaseRemovedPeers();
 }
 
 void SocketSctp::connect(const RemoteIPSockets& remotes)
@@ -33,28 +158,61 @@ void SocketSctp::connectMultihomed(const RemoteIPSockets& remotes)
 }
 
 void SocketSctp::send(const ChatMessage& msg)
+{
+    sendToAll(msg, {});
+}
+
+void SocketSctp::sendPartiallyReliable(const ChatMessage& msg, const PrInfo& pr_info)
+{
+    sendToAll(msg, pr_info);
+}
+
+void SocketSctp::sendToAll(const ChatMessage& msg, optional<PrInfo> pr_info)
 {
     LOCK_MTX(peers_mtx);
 
-    for (auto& p : peers)
-    {
-        const FD fd = p.second.fd;
-        config.big_msg_size ? sendBigMessage(fd) : send(fd, msg);
-    }
+    // one payload for the whole fan-out, io_uring keeps it alive until the last send completes
+    const auto payload = big_msg ? big_msg : make_shared<const ChatMessage>(msg);
+    const auto stream = select_stream(msg);
+    // peers_mtx is held throughout, so congested peers must not each get a block timeout of their own
+    const auto block_until = chrono::steady_clock::now() + config.send_queue_limits.block_timeout;
+    for (const auto& peer : peers)
+        send(fdOf(peer), payload, stream % peer.outbound_streams, peer.assoc_id, pr_info, block_until);
 }
 
 void SocketSctp::configure(FD fd)
 {
     Socket::configure(fd);
-    configureNoDelay(fd);
+    // when batching, SCTP may bundle chunks on its own and MSG_MORE plus the batch flush decide when they leave
+    if (not config.batch_delay.count())
+        configureNoDelay(fd);
     configureReceivingEvents(fd);
-    configureInitParams(fd, InitMaxAttempts{5}, InitMaxTimeoutInMs{5000});
+    configureInitParams(fd,
+                        InitMaxAttempts{5},
+                        InitMaxTimeoutInMs{5000},
+                        OutStreams{config.out_streams},
+                        MaxInStreams{config.max_in_streams});
     configureRto(fd, RtoInitialInMs{1000}, RtoMinInMs{1000}, RtoMaxInMs{5000});
-    configureSack(fd, SackFreq{2}, SackDelay{200});
+    configureSack(fd, sctp_sack_freq, SackDelay{200});
     configureMaxRetrans(fd, 5);
     configureIPv4AddressMapping(fd);
-    configurePeerAddressParams(fd, HbInterval{10000}, PathMaxRetrans{3}, PathMtu{config.path_mtu});
+    configurePeerAddressParams(fd, HbInterval{10000}, sctp_path_max_retrans, PathMtu{config.path_mtu});
     configureMaxSeg(fd, config.max_seg);
+    if (config.partial_delivery_point)
+        configurePartialDeliveryPoint(fd, config.partial_delivery_point);
+    configureFragmentInterleave(fd, interleaving ? full_interleave : config.fragment_interleave);
+    if (interleaving)
+        configureInterleaving(fd);
+    if (config.stream_scheduler != StreamScheduler::FirstComeFirstServed)
+        configureStreamScheduler(fd, toSctpScheduler(config.stream_scheduler));
+    if (config.asconf)
+        configureAsconf(fd);
+    if (usesPrSctp(config))
+    {
+        configurePrSupported(fd);
+        configureDefaultPrInfo(
+            fd, toSctpPrPolicy(config.default_pr_info.policy), config.default_pr_info.value);
+    }
 }
 
 static void checkPorts(const LocalIPSockets& locals)
@@ -75,24 +233,52 @@ void SocketSctp::bind(FD fd, const LocalIPSockets& locals)
     DEBUG_LOG << "Bound addresses: " << getBoundAddresses(fd);
 }
 
-LocalIPSockets SocketSctp::getBoundAddresses(FD fd) const
+void SocketSctp::addLocalAddress(const IP& addr)
 {
-    return getLaddrs(fd);
+    rebind(addr, SCTP_BINDX_ADD_ADDR);
 }
 
-RemoteIPSockets SocketSctp::getPeerAddresses(FD fd) const
+void SocketSctp::removeLocalAddress(const IP& addr)
 {
-    return getPaddrs(fd);
+    rebind(addr, SCTP_BINDX_REM_ADDR);
 }
 
-FDs SocketSctp::selectFds()
+void SocketSctp::rebind(const IP& addr, int bindx_flags)
 {
+    // all addresses of an SCTP endpoint share one port
+    const LocalIPSockets locals{IPSocket{addr, config.locals.front().port}};
+    const auto adding = bindx_flags == SCTP_BINDX_ADD_ADDR;
+    // neither IPv4 nor IPv6 - converting it would throw, and a typo on the console is not worth the whole task
+    if (locals.front().family == AF_UNIX)
+    {
+        WARN_LOG << "Cannot " << (adding ? "add " : "remove ") << addr << ": not an IP address";
+        return;
+    }
+    INFO_LOG << (adding ? "Adding " : "Removing ") << locals << " on fd = " << fd;
+    auto saddrs = toSockaddrs(locals);
+
+    // a peeled off association has its own copy of the bound addresses, so it is updated separately. The kernel
+    // tells the peers with ASCONF, the associations stay up. An address the kernel rejects is only logged.
     LOCK_MTX(peers_mtx);
-    fd_set.reset();
-    fd_set.set(fd);
-    for (const auto& peer : peers)
-        fd_set.set(peer.second.fd);
-    return fd_set.select();
+    FDs fds{fd};
+    if (config.peel_off)
+        for (const auto& peer : peers)
+            fds.push_back(peer.fd);
+    for (const auto target : fds)
+        if (sctp_bindx(target, asSockaddrPtr(saddrs.data()), locals.size(), bindx_flags) != 0)
+            WARN_LOG << "sctp_bindx failed on fd = " << target << ": " << strerror(errno);
+
+    DEBUG_LOG << "Bound addresses: " << getBoundAddresses(fd);
+}
+
+LocalIPSockets SocketSctp::getBoundAddresses(FD fd) const
+{
+    return getLaddrs(fd);
+}
+
+RemoteIPSockets SocketSctp::getPeerAddresses(FD fd) const
+{
+    return getPaddrs(fd);
 }
 
 void SocketSctp::handleMessage(FD fd)
@@ -102,46 +288,233 @@ void SocketSctp::handleMessage(FD fd)
     sctp_sndrcvinfo sndrcvinfo;
     int flags = 0; // !!!
 
-    auto& msg_buffer = getBuffer(fd);
-    msg_buffer[checkedReceive(sctp_recvmsg(
-        fd, msg_buffer.data(), msg_buffer.size(), asSockaddrPtr(from_storage), &from_len, &sndrcvinfo, &flags))] = 0;
+    if (stats and fd == stats->endpoint())
+    {
+        for (const auto reader : stats->serve())
+            watchWritable(reader);
+        return;
+    }
+
+    auto& msg_buffer = getBufferPtr(fd);
+    if (not msg_buffer)
+    {
+        WARN_LOG << "No buffer for fd = " << fd << ", it was already removed";
+        return;
+    }
+    const Size length = checkedReceive(sctp_recvmsg(
+        fd, msg_buffer->data(), msg_buffer->size(), asSockaddrPtr(from_storage), &from_len, &sndrcvinfo, &flags));
 
     if (flags & MSG_NOTIFICATION)
-        handle({from_storage, reinterpret_cast<const sctp_notification&>(msg_buffer.front())});
+        handle({from_storage, reinterpret_cast<const sctp_notification&>(msg_buffer->front())});
     else
+        reassemble(from_storage, sndrcvinfo, msg_buffer, length, flags & MSG_EOR);
+}
+
+void SocketSctp::handleWritable(FD fd)
+{
+    // writability is watched one-shot, so a stats reader is watched again for as long as it is owed more
+    if (stats and stats->owes(fd))
     {
-        const ChatMessage msg{msg_buffer.data()};
-        INFO_LOG << "Received message: " << (msg.size() < 100 ? msg : "BIG") << " (size = " << msg.size() << ") from "
-                 << from_storage;
+        unwatch(fd);
+        if (not stats->resume(fd))
+            watchWritable(fd);
+        return;
     }
+
+    // remove() clears the slot on a worker, so it is only read under the same lock
+    LOCK_MTX(peers_mtx);
+    if (const auto& queue = send_queues[fd])
+        queue->flush();
 }
 
 IOBuffer& SocketSctp::getBuffer(FD fd)
 {
-    LOCK_MTX(peers_mtx);
-    return *(fd == this->fd ? main_msg_buffer :
-                              find_if(peers, [fd](auto& peer) { return peer.second.fd == fd; })->second.msg_buffer);
+    return *getBufferPtr(fd);
+}
+
+SocketSctp::BufferPtr& SocketSctp::getBufferPtr(FD fd)
+{
+    return fd == this->fd ? main_msg_buffer : peer_buffers[fd];
+}
+
+void SocketSctp::reassemble(
+    const IPSocket& from, const sctp_sndrcvinfo& sndrcvinfo, BufferPtr& buffer, Size length, bool complete)
+{
+    const ReassemblyKey key{sndrcvinfo.sinfo_assoc_id, sndrcvinfo.sinfo_stream};
+    lock_guard<mutex> lock{reassemblies_mtx};
+    const auto it = reassemblies.find(key);
+
+    // a peer that never sends MSG_EOR would otherwise pin pool buffers without bound
+    const auto is_discarded = discarded_reassemblies.count(key) > 0;
+    if (is_discarded or (not complete and reassembledBytes(key.first) + length > max_reassembly_bytes))
+    {
+        if (not is_discarded)
+        {
+            WARN_LOG << "Dropping reassembly on assoc_id = " << key.first << ", stream = " << key.second
+                     << ": over " << max_reassembly_bytes << " bytes buffered for the association";
+            if (it != end(reassemblies))
+                reassemblies.erase(it);
+        }
+        if (complete)
+            discarded_reassemblies.erase(key);
+        else
+            discarded_reassemblies.insert(key);
+        return;
+    }
+
+    // the common case - the whole message fit into one receive, so it is viewed right where it landed
+    if (complete and it == end(reassemblies))
+        return handleReceived(from, sndrcvinfo, {{buffer->data(), length}});
+
+    // short pieces are copied behind the previous one, otherwise the filled buffer joins the chain and the fd gets
+    // a fresh one, so large messages are neither copied nor reallocated
+    auto& chunks = it == end(reassemblies) ? reassemblies[key] : it->second;
+    if (not chunks.empty() and chunks.back().buffer->size() - chunks.back().length >= length)
+    {
+        auto& tail = chunks.back();
+        memcpy(tail.buffer->data() + tail.length, buffer->data(), length);
+        tail.length += length;
+    }
+    else
+    {
+        chunks.push_back({move(buffer), length});
+        buffer = peer_msg_buffers.get();
+    }
+    DEBUG_LOG << "Partial delivery on assoc_id = " << key.first << ", stream = " << key.second << ", "
+              << chunks.size() << " chunks so far";
+
+    if (not complete)
+        return;
+
+    MessageView view;
+    for (const auto& chunk : chunks)
+        view.emplace_back(chunk.buffer->data(), chunk.length);
+    handleReceived(from, sndrcvinfo, view);
+    reassemblies.erase(key);
 }
 
-void SocketSctp::sendBigMessage(FD fd)
+Size SocketSctp::reassembledBytes(AssocId assoc_id) const
 {
-    ChatMessage big_msg;
-    big_msg.resize(config.big_msg_size);
-    fill(big_msg, 'x');
-    send(fd, big_msg);
+    Size bytes = 0;
+    for (auto it = reassemblies.lower_bound({assoc_id, 0}); it != end(reassemblies) and it->first.first == assoc_id;
+         ++it)
+        for (const auto& chunk : it->second)
+            bytes += chunk.length;
+    return bytes;
 }
 
-void SocketSctp::send(FD fd, const ChatMessage& p_msg)
+void SocketSctp::handleReceived(const IPSocket& from, const sctp_sndrcvinfo& sndrcvinfo, const MessageView& view)
 {
+    Size size = 0;
+    for (const auto& piece : view)
+        size += piece.size();
+
+    INFO_LOG << "Received message: " << (size < 100 ? view.front() : "BIG") << " (size = " << size << ") from " << from
+             << " on stream " << sndrcvinfo.sinfo_stream;
+    countReceived(sndrcvinfo.sinfo_stream, size);
+}
+
+void SocketSctp::dropReassembly(AssocId assoc_id)
+{
+    lock_guard<mutex> lock{reassemblies_mtx};
+    erase_if(reassemblies, [assoc_id](const auto& reassembly) { return reassembly.first.first == assoc_id; });
+    erase_if(discarded_reassemblies, [assoc_id](const auto& key) { return key.first == assoc_id; });
+}
+
+void SocketSctp::dropReassembly(AssocId assoc_id, StreamId stream)
+{
+    WARN_LOG << "Partial delivery aborted on assoc_id = " << assoc_id << ", stream = " << stream;
+    lock_guard<mutex> lock{reassemblies_mtx};
+    reassemblies.erase({assoc_id, stream});
+    discarded_reassemblies.erase({assoc_id, stream});
+}
+
+namespace
+{
+    template <class Info>
+    void appendCmsg(ControlBuffer& control, int type, const Info& info)
+    {
+        const auto offset = control.size();
+        control.resize(offset + CMSG_SPACE(sizeof(Info)));
+
+        cmsghdr cmsg{};
+        cmsg.cmsg_level = IPPROTO_SCTP;
+        cmsg.cmsg_type = type;
+        cmsg.cmsg_len = CMSG_LEN(sizeof(Info));
+        memcpy(control.data() + offset, &cmsg, sizeof(cmsg));
+        memcpy(control.data() + offset + CMSG_LEN(0), &info, sizeof(info));
+    }
+} // namespace
+
+ControlBuffer SocketSctp::sendControl(StreamId stream, AssocId assoc_id, optional<PrInfo> pr_info) const
+{
+    ControlBuffer control;
+
+    // the assoc id picks the association on a one-to-many socket and is ignored on peeled off ones
+    sctp_sndinfo snd_info{};
+    snd_info.snd_sid = stream;
+    snd_info.snd_assoc_id = assoc_id;
+    appendCmsg(control, SCTP_SNDINFO, snd_info);
+
+    if (const auto it = config.stream_pr_infos.find(stream); not pr_info and it != end(config.stream_pr_infos))
+        pr_info = it->second;
+    if (pr_info)
+    {
+        sctp_prinfo info{};
+        info.pr_policy = toSctpPrPolicy(pr_info->policy);
+        info.pr_value = pr_info->value;
+        appendCmsg(control, SCTP_PRINFO, info);
+    }
+
+    return control;
+}
+
+void SocketSctp::send(FD fd,
+                      const SharedChatMessage& payload,
+                      StreamId stream,
+                      AssocId assoc_id,
+                      optional<PrInfo> pr_info,
+                      optional<SendQueue::Deadline> block_until)
+{
+    const auto& p_msg = *payload;
     const string msg = "HABBA";
     INFO_LOG << "Sending message: " << (p_msg.size() < 100 ? p_msg : msg) << " (size = " << p_msg.size()
-             << ") on fd = " << fd;
-    checkSend(::send(fd, p_msg.data(), p_msg.size(), ignore_flags));
+             << ") on fd = " << fd << ", stream = " << stream << ", assoc_id = " << assoc_id;
+    countSent(stream, p_msg.size());
+
+    auto control = sendControl(stream, assoc_id, pr_info);
+    if (uring)
+        return uring->send(fd, payload, control);
+
+    // a message the socket cannot take right now waits for the fd to turn writable, without holding up other peers
+    send_queues[fd]->send({payload}, move(control), block_until);
+}
+
+void SocketSctp::countSent(StreamId stream, Size bytes)
+{
+    lock_guard<mutex> lock{stream_counters_mtx};
+    auto& counters = stream_counters[stream];
+    ++counters.sent_msgs;
+    counters.sent_bytes += bytes;
+}
+
+void SocketSctp::countReceived(StreamId stream, Size bytes)
+{
+    lock_guard<mutex> lock{stream_counters_mtx};
+    auto& counters = stream_counters[stream];
+    ++counters.received_msgs;
+    counters.received_bytes += bytes;
 }
 
 namespace
 {
     auto isAssocChange(const sctp_notification& sn) { return sn.sn_header.sn_type == SCTP_ASSOC_CHANGE; }
+    auto isPeerAddrChange(const sctp_notification& sn) { return sn.sn_header.sn_type == SCTP_PEER_ADDR_CHANGE; }
+    auto isPartialDeliveryAbort(const sctp_notification& sn)
+    {
+        return sn.sn_header.sn_type == SCTP_PARTIAL_DELIVERY_EVENT and
+               sn.sn_pdapi_event.pdapi_indication == SCTP_PARTIAL_DELIVERY_ABORTED;
+    }
 
     void logPeerInfo(FD fd, AssocId assoc_id)
     {
@@ -189,6 +562,7 @@ auto& operator<<(ostream& os, const sctp_notification& sn)
                 case SCTP_ADDR_ADDED: os << "SCTP_ADDR_ADDED"; break;
                 case SCTP_ADDR_MADE_PRIM: os << "SCTP_ADDR_MADE_PRIM"; break;
                 case SCTP_ADDR_CONFIRMED: os << "SCTP_ADDR_CONFIRMED"; break;
+                case SCTP_ADDR_POTENTIALLY_FAILED: os << "SCTP_ADDR_POTENTIALLY_FAILED"; break;
                 default: os << "UNKNOWN";
             }
             return os << ", addr = " << IPSocket{msg.spc_aaddr};
@@ -213,6 +587,12 @@ void SocketSctp::handle(const SocketSctp::Notification& n)
 
     INFO_LOG << "Received notification: " << sn << " from " << from;
 
+    if (isPartialDeliveryAbort(sn))
+        return dropReassembly(sn.sn_pdapi_event.pdapi_assoc_id, sn.sn_pdapi_event.pdapi_stream);
+
+    if (isPeerAddrChange(sn))
+        return handleAddressChange(sn.sn_paddr_change);
+
     if (isAssocChange(sn))
     {
         const auto& sac = sn.sn_assoc_change;
@@ -230,7 +610,7 @@ void SocketSctp::handle(const SocketSctp::Notification& n)
 
         switch (state)
         {
-            case SCTP_COMM_UP: return handleCommUp(assoc_id);
+            case SCTP_COMM_UP: return handleCommUp(assoc_id, sac.sac_outbound_streams);
             case SCTP_CANT_STR_ASSOC: return handleEstablishmentFailure(from);
             case SCTP_SHUTDOWN_COMP: return handleGracefulShutdown(assoc_id);
             case SCTP_COMM_LOST: return handleCommLost(assoc_id, from);
@@ -238,9 +618,19 @@ void SocketSctp::handle(const SocketSctp::Notification& n)
     }
 }
 
-void SocketSctp::handleCommUp(AssocId assoc_id)
+void SocketSctp::handleCommUp(AssocId assoc_id, StreamId outbound_streams)
 {
-    peelOff(assoc_id);
+    DEBUG_LOG << "assoc_id = " << assoc_id << " negotiated " << outbound_streams << " outbound streams";
+    // stream values only exist once the association is up, and the main socket still owns it before peeloff
+    for (const auto& [stream, priority] : config.stream_priorities)
+        if (stream < outbound_streams)
+            configureStreamPriority(fd, stream, priority, assoc_id);
+    if (path_manager)
+    {
+        LOCK_MTX(peers_mtx);
+        path_manager->configure(fd, assoc_id);
+    }
+    config.peel_off ? peelOff(assoc_id, outbound_streams) : track(assoc_id, outbound_streams);
 }
 
 void SocketSctp::handleEstablishmentFailure(const RemoteIPSocket& remote)
@@ -259,17 +649,156 @@ void SocketSctp::handleCommLost(AssocId assoc_id, const RemoteIPSocket& remote)
     scheduleReestablishment(remote);
 }
 
-void SocketSctp::peelOff(AssocId assoc_id)
+void SocketSctp::peelOff(AssocId assoc_id, StreamId outbound_streams)
 {
     LOCK_MTX(peers_mtx);
     FileDescriptor peeled_fd{checkedPeeloff(sctp_peeloff(fd, assoc_id))};
     logPeerInfo(peeled_fd, assoc_id);
-    peers.emplace(assoc_id, Peer{move(peeled_fd), peer_msg_buffers.get()});
+    // the buffer has to be in place before the fd is watched
+    peer_buffers[peeled_fd] = peer_msg_buffers.get();
+    send_queues[peeled_fd] = createSendQueue(
+        peeled_fd, SendQueue::PreservesBoundaries{true}, SendQueue::SupportsMsgMore{true}, config.send_queue_limits);
+    watch(peeled_fd);
+    peer_slots[assoc_id] = peers.size();
+    peers.push_back(Peer{assoc_id, move(peeled_fd), outbound_streams});
+}
+
+void SocketSctp::logAbandoned() const
+{
+    LOCK_MTX(peers_mtx);
+    for (const auto& peer : peers)
+    {
+        const auto assoc_id = peer.assoc_id;
+        sctp_prstatus status{};
+        status.sprstat_assoc_id = assoc_id;
+        status.sprstat_policy = SCTP_PR_SCTP_ALL;
+        socklen_t len = sizeof(status);
+        // an association going down in the meantime is not worth an exception
+        if (::getsockopt(fdOf(peer), IPPROTO_SCTP, SCTP_PR_ASSOC_STATUS, &status, &len) != 0)
+            continue;
+        INFO_LOG << "PR-SCTP on assoc_id = " << assoc_id << " abandoned " << status.sprstat_abandoned_unsent
+                 << " unsent and " << status.sprstat_abandoned_sent << " sent messages";
+    }
+}
+
+void SocketSctp::tuneAssociations()
+{
+    LOCK_MTX(peers_mtx);
+    for (const auto& peer : peers)
+        tuner->tune(fdOf(peer), peer.assoc_id);
+}
+
+void SocketSctp::evaluatePaths()
+{
+    LOCK_MTX(peers_mtx);
+    for (const auto& peer : peers)
+        path_manager->evaluate(fdOf(peer), peer.assoc_id);
+}
+
+void SocketSctp::sampleStats()
+{
+    {
+        LOCK_MTX(peers_mtx);
+        for (const auto& peer : peers)
+            stats->sample(fdOf(peer), peer.assoc_id);
+    }
+    stats->flushFile();
+}
+
+void SocketSctp::flushBatches()
+{
+    LOCK_MTX(peers_mtx);
+    if (const auto& queue = send_queues[fd])
+        queue->flush();
+    if (config.peel_off)
+        for (const auto& peer : peers)
+            if (const auto& queue = send_queues[peer.fd])
+                queue->flush();
+}
+
+void SocketSctp::handleAddressChange(const sctp_paddr_change& change)
+{
+    if (not path_manager)
+        return;
+
+    LOCK_MTX(peers_mtx);
+    if (const auto peer = findPeer(change.spc_assoc_id))
+        path_manager->handleAddressChange(fdOf(*peer), change);
+}
+
+SocketSctp::Peer* SocketSctp::findPeer(AssocId assoc_id)
+{
+    const auto it = peer_slots.find(assoc_id);
+    return it == end(peer_slots) ? nullptr : &peers[it->second];
+}
+
+FD SocketSctp::fdOf(const Peer& peer) const
+{
+    return config.peel_off ? FD{peer.fd} : fd;
+}
+
+void SocketSctp::track(AssocId assoc_id, StreamId outbound_streams)
+{
+    LOCK_MTX(peers_mtx);
+    peer_slots[assoc_id] = peers.size();
+    peers.push_back(Peer{assoc_id, FileDescriptor{}, outbound_streams});
+    DEBUG_LOG << "Tracking assoc_id = " << assoc_id << " on fd = " << fd << ", " << peers.size()
+              << " associations share it";
+}
+
+void SocketSctp::reportLoad()
+{
+    // compares -no_peeloff with peeloff: every peeled off association is one more fd to watch and to wake up for
+    Size associations;
+    {
+        LOCK_MTX(peers_mtx);
+        associations = peers.size();
+    }
+    INFO_LOG << "Load: " << associations << " associations on " << watchedFdCount() << " watched fds, "
+             << load.wakeups << " wakeups handling " << load.events << " events in the last "
+             << config.load_report_period.count() << " ms";
+    load = {};
 }
 
 void SocketSctp::remove(AssocId assoc_id)
 {
+    dropReassembly(assoc_id);
     LOCK_MTX(peers_mtx);
-    peers.erase(assoc_id);
+    const auto it = peer_slots.find(assoc_id);
+    if (it == end(peer_slots))
+        return;
+    const auto slot = it->second;
+    peer_slots.erase(it);
+
+    auto& peer = peers[slot];
+    if (config.peel_off)
+    {
+        unwatch(peer.fd);
+        removed_fds.push_back(move(peer.fd));
+    }
+    if (tuner)
+        tuner->forget(assoc_id);
+    if (path_manager)
+        path_manager->forget(assoc_id);
+
+    // swap and pop keeps the table dense, only the moved peer's slot changes
+    if (slot != peers.size() - 1)
+    {
+        peer = move(peers.back());
+        peer_slots[peer.assoc_id] = slot;
+    }
+    peers.pop_back();
     DEBUG_LOG << "Removed assoc_id = " << assoc_id;
 }
+
+void SocketSctp::releaseRemovedPeers()
+{
+    // every worker is done by now, so the buffers are unused and the fd numbers may be handed out again
+    LOCK_MTX(peers_mtx);
+    for (const auto& removed_fd : removed_fds)
+    {
+        peer_buffers[removed_fd] = BufferPtr{};
+        send_queues[removed_fd] = {};
+    }
+    removed_fds.clear();
+}
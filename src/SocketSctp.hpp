@@ -1,26 +1,44 @@
 #pragma once
 
+#include <map>
+#include <optional>
+#include <set>
+#include <string_view>
 #include <unordered_map>
+#include "Constants.hpp"
+#include "FdTable.hpp"
+#include "PrPolicy.hpp"
+#include "SctpPathManager.hpp"
+#include "SctpStatsSampler.hpp"
+#include "SctpTuner.hpp"
 #include "Socket.hpp"
+#include "StreamSelector.hpp"
+#include "TimerWheel.hpp"
 
 struct NetworkConfiguration;
 
 class SocketSctp : public Socket
 {
 public:
-    SocketSctp(const NetworkConfiguration&, TaskScheduler&);
+    SocketSctp(const NetworkConfiguration&, TimerWheel&);
+    ~SocketSctp();
 
+    void useIoUring() override;
+    void receive(Timeout = Timeout{100}) override;
     void connect(const RemoteIPSockets&) override;
     void connectMultihomed(const RemoteIPSockets&) override;
     void send(const ChatMessage&) override;
+    void sendPartiallyReliable(const ChatMessage&, const PrInfo&) override;
+    void addLocalAddress(const IP&) override;
+    void removeLocalAddress(const IP&) override;
 
 private:
     void configure(FD) override;
     void bind(FD, const LocalIPSockets&) override;
     LocalIPSockets getBoundAddresses(FD) const override;
     RemoteIPSockets getPeerAddresses(FD) const override;
-    FDs selectFds() override;
     void handleMessage(FD) override;
+    void handleWritable(FD) override;
     IOBuffer& getBuffer(FD) override;
 
     struct Notification
@@ -32,23 +50,100 @@ private:
 #pragma GCC diagnostic pop
     };
 
-    void sendBigMessage(FD);
-    void send(FD, const ChatMessage&);
+    // pieces of one reassembled message in arrival order, pointing straight into the pool buffers
+    using MessageView = std::vector<std::string_view>;
+
+    BufferPtr& getBufferPtr(FD);
+    void reassemble(const IPSocket& from, const sctp_sndrcvinfo&, BufferPtr&, Size length, bool complete);
+    void handleReceived(const IPSocket& from, const sctp_sndrcvinfo&, const MessageView&);
+    void dropReassembly(AssocId);
+    void dropReassembly(AssocId, StreamId);
+    void sendToAll(const ChatMessage&, std::optional<PrInfo>);
+    // without an explicit PR-SCTP policy the one configured for the stream (or the socket default) applies
+    void send(FD,
+              const SharedChatMessage&,
+              StreamId = 0,
+              AssocId = ignore_assoc,
+              std::optional<PrInfo> = {},
+              std::optional<SendQueue::Deadline> block_until = {});
+    ControlBuffer sendControl(StreamId, AssocId, std::optional<PrInfo>) const;
+    void logAbandoned() const;
+    void tuneAssociations();
+    void evaluatePaths();
+    void sampleStats();
+    void reportLoad();
+    void flushBatches();
+    void handleAddressChange(const sctp_paddr_change&);
+    void rebind(const IP&, int bindx_flags);
     void handle(const Notification&);
-    void handleCommUp(AssocId);
+    void handleCommUp(AssocId, StreamId outbound_streams);
     void handleEstablishmentFailure(const RemoteIPSocket&);
     void handleGracefulShutdown(AssocId);
     void handleCommLost(AssocId, const RemoteIPSocket&);
-    void peelOff(AssocId);
+    void peelOff(AssocId, StreamId outbound_streams);
+    void track(AssocId, StreamId outbound_streams);
     void remove(AssocId);
+    void releaseRemovedPeers();
 
+    // without peeloff a peer is just a table entry - its fd stays empty and the main socket serves it
     struct Peer
     {
+        AssocId assoc_id;
         FileDescriptor fd;
-        BufferPtr msg_buffer;
+        StreamId outbound_streams;
     };
-    using Peers = std::unordered_map<AssocId, Peer>;
+    using Peers = std::vector<Peer>;
+    using PeerSlot = Size;
+    Peer* findPeer(AssocId);
+    FD fdOf(const Peer&) const;
+    // dense for the fan-out loops, with slots found by assoc id - guarded by peers_mtx
     Peers peers;
+    std::unordered_map<AssocId, PeerSlot> peer_slots;
     mutable std::mutex peers_mtx;
+    // the receive path finds the buffer of a peeled off fd here without touching peers_mtx
+    FdTable<BufferPtr> peer_buffers;
+    // one per fd, so without peeloff all associations share the queue of the main socket - guarded by peers_mtx
+    FdTable<std::shared_ptr<SendQueue>> send_queues;
+    // peeled off fds removed on a worker stay open, with their buffer, until no other worker can be receiving on
+    // them - guarded by peers_mtx
+    std::vector<FileDescriptor> removed_fds;
+
+    struct StreamCounters
+    {
+        Size sent_msgs{};
+        Size sent_bytes{};
+        Size received_msgs{};
+        Size received_bytes{};
+    };
+    void countSent(StreamId, Size bytes);
+    void countReceived(StreamId, Size bytes);
+    std::map<StreamId, StreamCounters> stream_counters;
+    std::mutex stream_counters_mtx;
+
+    // messages split by partial delivery grow by pool buffers until MSG_EOR arrives
+    struct Chunk
+    {
+        BufferPtr buffer;
+        Size length;
+    };
+    using Chunks = std::vector<Chunk>;
+    using ReassemblyKey = std::pair<AssocId, StreamId>;
+    Size reassembledBytes(AssocId) const;
+    std::map<ReassemblyKey, Chunks> reassemblies;
+    std::set<ReassemblyKey> discarded_reassemblies; // over the limit, the rest is skipped until MSG_EOR
+    std::mutex reassemblies_mtx;
+
+    StreamSelector select_stream;
+    SharedChatMessage big_msg;
+    TimerWheel::TimerPtr pr_status_task;
+    std::optional<SctpTuner> tuner;
+    TimerWheel::TimerPtr tune_task;
+    std::optional<SctpPathManager> path_manager;
+    TimerWheel::TimerPtr path_task;
+    std::unique_ptr<SctpStatsSampler> stats;
+    TimerWheel::TimerPtr stats_task;
+    TimerWheel::TimerPtr batch_task;
+    TimerWheel::TimerPtr load_task;
     const NetworkConfiguration& config;
+    const bool interleaving; // -interleaving, unless the kernel refuses I-DATA
 };
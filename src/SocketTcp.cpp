@@ -1,61 +1,90 @@
 #include "SocketTcp.hpp"
+#include <cstring>
+#include "NetworkConfiguration.hpp"
 #include "SocketConfiguration.hpp"
 #include "SocketErrorChecks.hpp"
 #include "SocketIO.hpp"
 
 using namespace std;
 
-SocketTcp::SocketTcp(const LocalIPSockets& locals, TaskScheduler& ts, Type type)
-    : Socket(locals, ts, type), local(locals.front().addr), type(type)
+namespace
+{
+    constexpr auto forever = numeric_limits<TimerWheel::Repetitions>::max();
+}
+
+SocketTcp::SocketTcp(const NetworkConfiguration& cfg, TimerWheel& ts, Type type)
+    : Socket(cfg.locals, ts, type), local(cfg.locals.front().addr), type(type), config(cfg)
 {
     SocketTcp::configure(fd);
     DEBUG_LOG << "Configured fd = " << fd;
-    SocketTcp::bind(fd, locals);
+    SocketTcp::bind(fd, config.locals);
+    if (config.threads > 1 and config.steer_by_cpu and type == SOCK_STREAM)
+        configureReusePortCpuSteering(fd, config.threads);
+
+    if (config.batch_delay.count())
+        batch_task = task_scheduler.schedule([this] { flushBatches(); }, config.batch_delay, forever);
+}
+
+SocketTcp::~SocketTcp()
+{
+    if (auto task = batch_task.lock())
+        task->disable();
+
+    LOCK_MTX(peers_mtx);
+    for (const auto& [fd, pending] : connecting)
+        if (auto task = pending.timeout.lock())
+            task->disable();
 }
 
 void SocketTcp::connect(const RemoteIPSockets& remotes)
 {
+    // connects are only started here, so the whole batch is in flight at once and each one completes on its own
     LOCK_MTX(peers_mtx);
     for (const auto& remote : remotes)
     {
         auto fd = createConnectSocket();
         Socket::connect(fd, remote);
-        peers.emplace(fd, Peer{move(fd), peer_msg_buffers.get(), remote, ShouldReestablish{true}});
+        const auto id = next_connect_id++;
+        auto timeout = task_scheduler.schedule([this, fd = FD{fd}, id] { handleConnectTimeout(fd, id); },
+                                               config.connect_timeout);
+        watchWritable(fd);
+        connecting.emplace(FD{fd}, PendingConnect{move(fd), remote, id, chrono::steady_clock::now(), move(timeout)});
     }
 }
 
 void SocketTcp::send(const ChatMessage& msg)
 {
+    const auto framed = frame(msg);
     LOCK_MTX(peers_mtx);
+    // peers_mtx is held throughout, so congested peers must not each get a block timeout of their own
+    const auto block_until = chrono::steady_clock::now() + config.send_queue_limits.block_timeout;
     for (const auto& p : peers)
-        sendMessage(msg, p.second);
+        sendMessage(framed, p.second, block_until);
 }
 
 void SocketTcp::configure(FD fd)
 {
     Socket::configure(fd);
+    if (config.threads > 1)
+        configureReusePort(fd);
     if (type == SOCK_STREAM)
         configureKeepAlive(fd, KeepAliveTimeInS{1}, KeepAliveIntervalInS{1}, KeepAliveProbes{3});
-}
-
-FDs SocketTcp::selectFds()
-{
-    LOCK_MTX(peers_mtx);
-    fd_set.reset();
-    fd_set.set(fd);
-    for (const auto& peer : peers)
-        fd_set.set(peer.second.fd);
-    return fd_set.select();
+    // batches decide where segments end - MSG_MORE holds back all but the last write of a flush, which leaves at once
+    if (type == SOCK_STREAM and config.batch_delay.count())
+        configureTcpNoDelay(fd);
 }
 
 void SocketTcp::handleMessage(FD fd)
 {
     if (fd == this->fd)
         return handleCommUp();
+    if (auto pending = takePendingConnect(fd))
+        return handleConnectCompletion(move(*pending));
 
+    string_view data;
     try
     {
-        receiveMessage(fd);
+        data = receiveMessage(fd);
     }
     catch (const runtime_error& ex)
     {
@@ -63,12 +92,72 @@ void SocketTcp::handleMessage(FD fd)
         return handleCommLost(fd);
     }
 
-    const ChatMessage msg{getBuffer(fd).data()};
+    handleData(fd, data);
+}
+
+void SocketTcp::handleCompletion(const IoUring::Completion& completion)
+{
+    const auto fd = completion.fd;
+    if (fd == this->fd)
+        return handleCommUp();
+    if (completion.writable)
+        return handleWritable(fd);
+
+    if (completion.result < 0)
+    {
+        WARN_LOG << "Receive failed on fd = " << fd << ": " << strerror(-completion.result);
+        return handleCommLost(fd);
+    }
+
+    handleData(fd, completion.data);
+}
 
-    if (msg.empty())
-        return handleGracefulShutdown(fd);
+void SocketTcp::handleWritable(FD fd)
+{
+    if (auto pending = takePendingConnect(fd))
+        return handleConnectCompletion(move(*pending));
 
-    INFO_LOG << "Received message: " << msg << " (size = " << msg.size() << ") from " << getPeerAddresses(fd);
+    LOCK_MTX(peers_mtx);
+    if (const auto peer = peers.find(fd); peer != peers.end() and peer->second.send_queue)
+        peer->second.send_queue->flush();
+}
+
+void SocketTcp::flushBatches()
+{
+    LOCK_MTX(peers_mtx);
+    for (const auto& [fd, peer] : peers)
+        if (peer.send_queue)
+            peer.send_queue->flush();
+}
+
+void SocketTcp::handleData(FD fd, string_view data)
+{
+    if (data.empty())
+        return handleEndOfStream(fd);
+
+    try
+    {
+        // one read may carry many messages and end in the middle of one
+        if (const auto& frames = getParser(fd).parse(data); not frames.empty())
+            handleReceived(fd, frames);
+    }
+    catch (const runtime_error& ex)
+    {
+        WARN_LOG << "Broken framing on fd = " << fd << ": " << ex.what();
+        handleCommLost(fd);
+    }
+}
+
+void SocketTcp::handleReceived(FD fd, const FrameParser::Frames& frames)
+{
+    const auto from = getPeerAddresses(fd);
+    for (const auto& msg : frames)
+        INFO_LOG << "Received message: " << msg << " (size = " << msg.size() << ") from " << from;
+}
+
+void SocketTcp::handleEndOfStream(FD fd)
+{
+    handleGracefulShutdown(fd);
 }
 
 IOBuffer& SocketTcp::getBuffer(FD fd)
@@ -77,6 +166,12 @@ IOBuffer& SocketTcp::getBuffer(FD fd)
     return *peers.at(fd).msg_buffer;
 }
 
+FrameParser& SocketTcp::getParser(FD fd)
+{
+    LOCK_MTX(peers_mtx);
+    return peers.at(fd).parser;
+}
+
 FileDescriptor SocketTcp::createConnectSocket()
 {
     FileDescriptor fd{checkedSocket(socket(family, type, protocol))};
@@ -86,27 +181,115 @@ FileDescriptor SocketTcp::createConnectSocket()
     return fd;
 }
 
-void SocketTcp::sendMessage(const ChatMessage& msg, const SocketTcp::Peer& peer)
+optional<SocketTcp::PendingConnect> SocketTcp::takePendingConnect(FD fd, optional<ConnectId> id)
+{
+    LOCK_MTX(peers_mtx);
+    const auto it = connecting.find(fd);
+    // the fd may already belong to a newer connect when a stale timeout fires
+    if (it == connecting.end() or (id and it->second.id != *id))
+        return {};
+    auto pending = move(it->second);
+    connecting.erase(it);
+    return pending;
+}
+
+void SocketTcp::handleConnectCompletion(PendingConnect pending)
+{
+    if (auto task = pending.timeout.lock())
+        task->disable();
+    unwatch(pending.fd);
+
+    int error{};
+    getsockopt(pending.fd, SOL_SOCKET, SO_ERROR, error);
+    const auto setup_time =
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - pending.started).count();
+    if (error)
+    {
+        WARN_LOG << "Connecting to " << pending.remote << " on fd = " << pending.fd << " failed after " << setup_time
+                 << " us: " << strerror(error);
+        return scheduleReestablishment(pending.remote);
+    }
+
+    INFO_LOG << "Connected to " << pending.remote << " on fd = " << pending.fd << " in " << setup_time << " us";
+    LOCK_MTX(peers_mtx);
+    watchStream(pending.fd);
+    const FD fd = pending.fd;
+    peers.emplace(fd, createPeer(move(pending.fd), pending.remote, ShouldReestablish{true}));
+}
+
+void SocketTcp::handleConnectTimeout(FD fd, ConnectId id)
+{
+    auto pending = takePendingConnect(fd, id);
+    if (not pending)
+        return;
+
+    unwatch(fd);
+    WARN_LOG << "Connecting to " << pending->remote << " on fd = " << fd << " timed out after "
+             << config.connect_timeout.count() << " ms";
+    scheduleReestablishment(pending->remote);
+}
+
+SocketTcp::Peer SocketTcp::createPeer(FileDescriptor fd, const RemoteIPSocket& remote, ShouldReestablish reestablish)
+{
+    // DCCP sends every write as one datagram, so queued frames must not be glued together there
+    auto send_queue = createSendQueue(fd,
+                                      SendQueue::PreservesBoundaries{type == SOCK_DCCP},
+                                      SendQueue::SupportsMsgMore{type == SOCK_STREAM},
+                                      config.send_queue_limits);
+    return {move(fd), peer_msg_buffers.get(), {}, move(send_queue), remote, reestablish};
+}
+
+SendQueue::Pieces SocketTcp::frame(const ChatMessage& msg)
+{
+    // shared by every peer - a slow one keeps them alive in its queue instead of copying
+    return {make_shared<const ChatMessage>(frameHeader(msg.size())), make_shared<const ChatMessage>(msg)};
+}
+
+void SocketTcp::sendMessage(const SendQueue::Pieces& frame,
+                            const SocketTcp::Peer& peer,
+                            SendQueue::Deadline block_until)
 {
     const FD fd = peer.fd;
+    const auto& msg = *frame.back();
     INFO_LOG << "Sending message: " << msg << " (size = " << msg.size() << ") on fd = " << fd
              << ", remote = " << peer.remote;
-    checkSend(::send(fd, msg.data(), msg.size(), ignore_flags));
+    if (uring)
+        return uring->send(fd, *frame.front() + msg);
+
+    // header and payload leave in one gather write, right away or once the peer catches up
+    peer.send_queue->send(frame, {}, block_until);
 }
 
-void SocketTcp::receiveMessage(FD fd)
+string_view SocketTcp::receiveMessage(FD fd)
 {
     auto& msg_buffer = getBuffer(fd);
-    msg_buffer[checkedReceive(recv(fd, msg_buffer.data(), msg_buffer.size(), ignore_flags))] = 0;
+    const Size length = checkedReceive(recv(fd, msg_buffer.data(), msg_buffer.size(), ignore_flags));
+    return {msg_buffer.data(), length};
 }
 
 void SocketTcp::handleCommUp()
 {
+    // a reconnect storm is drained in one wakeup, and peers_mtx is taken once for the batch rather than per accept
+    vector<pair<FileDescriptor, RemoteIPSocket>> accepted;
+    try
+    {
+        while (auto accept_result = tryAccept())
+            accepted.push_back(move(*accept_result));
+    }
+    catch (const runtime_error& ex)
+    {
+        // e.g. EMFILE - what was accepted so far is kept, the rest stays in the backlog for the next wakeup
+        WARN_LOG << ex.what();
+    }
+    if (accepted.size() > 1)
+        DEBUG_LOG << "Accepted " << accepted.size() << " connections on fd = " << fd;
+
     LOCK_MTX(peers_mtx);
-    auto accept_result = accept();
-    auto& fd = accept_result.first;
-    const auto& remote = accept_result.second;
-    peers.emplace(FD{fd}, Peer{move(fd), peer_msg_buffers.get(), remote, ShouldReestablish{false}});
+    for (auto& [peer_fd, remote] : accepted)
+    {
+        watchStream(peer_fd);
+        peers.emplace(FD{peer_fd}, createPeer(move(peer_fd), remote, ShouldReestablish{false}));
+    }
 }
 
 void SocketTcp::handleGracefulShutdown(FD fd)
@@ -129,6 +312,7 @@ void SocketTcp::handleCommLost(FD fd)
 void SocketTcp::remove(FD fd)
 {
     LOCK_MTX(peers_mtx);
+    unwatch(fd);
     peers.erase(fd);
     DEBUG_LOG << "Removed fd = " << fd;
 }
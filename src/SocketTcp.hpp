@@ -1,20 +1,28 @@
 #pragma once
 
+#include <chrono>
 #include <map>
+#include <optional>
+#include "FrameParser.hpp"
 #include "Socket.hpp"
+#include "TimerWheel.hpp"
+
+struct NetworkConfiguration;
 
 class SocketTcp : public Socket
 {
 public:
-    SocketTcp(const LocalIPSockets&, TaskScheduler&, Type = SOCK_STREAM);
+    SocketTcp(const NetworkConfiguration&, TimerWheel&, Type = SOCK_STREAM);
+    ~SocketTcp();
 
     void connect(const RemoteIPSockets&) override;
     void send(const ChatMessage&) override;
 
 protected:
     void configure(FD) override;
-    FDs selectFds() override;
     void handleMessage(FD) override;
+    void handleCompletion(const IoUring::Completion&) override;
+    void handleWritable(FD) override;
     IOBuffer& getBuffer(FD) override;
 
     using ShouldReestablish = bool;
@@ -22,22 +30,49 @@ protected:
     {
         FileDescriptor fd;
         BufferPtr msg_buffer;
+        FrameParser parser;
+        std::shared_ptr<SendQueue> send_queue;
         RemoteIPSocket remote;
         ShouldReestablish should_reestablish;
     };
 
+    // a connect in flight - it becomes a Peer once the socket turns writable and SO_ERROR is clear
+    using ConnectId = u64;
+    struct PendingConnect
+    {
+        FileDescriptor fd;
+        RemoteIPSocket remote;
+        ConnectId id;
+        std::chrono::steady_clock::time_point started;
+        TimerWheel::TimerPtr timeout;
+    };
+
     FileDescriptor createConnectSocket();
-    void sendMessage(const ChatMessage&, const Peer&);
-    void receiveMessage(FD);
+    std::optional<PendingConnect> takePendingConnect(FD, std::optional<ConnectId> = {});
+    void handleConnectCompletion(PendingConnect);
+    void handleConnectTimeout(FD, ConnectId);
+    void flushBatches();
+    Peer createPeer(FileDescriptor, const RemoteIPSocket&, ShouldReestablish);
+    static SendQueue::Pieces frame(const ChatMessage&);
+    void sendMessage(const SendQueue::Pieces& frame, const Peer&, SendQueue::Deadline block_until);
+    std::string_view receiveMessage(FD);
+    void handleData(FD, std::string_view);
+    FrameParser& getParser(FD);
+    virtual void handleReceived(FD, const FrameParser::Frames&);
+    virtual void handleEndOfStream(FD);
     void handleCommUp();
     void handleGracefulShutdown(FD);
     void handleCommLost(FD);
     void remove(FD);
     using Peers = std::map<FD, Peer>;
     Peers peers;
+    std::map<FD, PendingConnect> connecting;
+    ConnectId next_connect_id{};
+    TimerWheel::TimerPtr batch_task;
     mutable std::mutex peers_mtx;
 
     IP local;
     Type type;
     Protocol protocol;
+    const NetworkConfiguration& config;
 };
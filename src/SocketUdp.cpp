@@ -1,21 +1,53 @@
 #include "SocketUdp.hpp"
+#include <cstring>
 #include <tools/ComparisonOperators.hpp>
 #include "Constants.hpp"
+#include "NetworkConfiguration.hpp"
+#include "SocketConfiguration.hpp"
 #include "SocketErrorChecks.hpp"
 
 using namespace std;
 
-SocketUdp::SocketUdp(const LocalIPSockets& locals, TaskScheduler& ts, Protocol protocol)
-    : Socket(locals, ts, SOCK_DGRAM, protocol), local(locals.front().addr)
+namespace
+{
+    constexpr auto receive_batch_size = 32;
+    constexpr auto no_timeout = nullptr;
+    constexpr Size max_datagram_size = 65507; // 64 KiB minus IPv4 and UDP headers
+    constexpr Size max_gso_segments = 64;
+
+    Size gsoChunkSize(SocketParam gso_size)
+    {
+        return min(max_gso_segments, max_datagram_size / gso_size) * gso_size;
+    }
+} // namespace
+
+SocketUdp::SocketUdp(const NetworkConfiguration& cfg, TimerWheel& ts, Protocol protocol)
+    : Socket(cfg.locals, ts, SOCK_DGRAM, protocol),
+      local(cfg.locals.front().addr),
+      config(cfg),
+      offload(cfg.gso_size and protocol != IPPROTO_UDPLITE)
 {
     SocketUdp::configure(fd);
     DEBUG_LOG << "Configured fd = " << fd;
-    SocketUdp::bind(fd, locals);
+    SocketUdp::bind(fd, config.locals);
+
+    receive_iovecs.resize(receive_batch_size);
+    receive_controls.resize(receive_batch_size);
+    receive_froms.resize(receive_batch_size);
+    receive_headers.resize(receive_batch_size);
+    for (auto i = 0; i < receive_batch_size; ++i)
+    {
+        receive_buffers.push_back(peer_msg_buffers.get());
+        receive_iovecs[i] = {receive_buffers[i]->data(), receive_buffers[i]->size()};
+    }
+
+    if (config.big_msg_size)
+        big_msg.assign(config.big_msg_size, 'x');
 }
 
 SocketUdp::~SocketUdp()
 {
-    SocketUdp::send(quit_msg);
+    sendToPeers(quit_msg);
 }
 
 void SocketUdp::connect(const RemoteIPSockets& remotes)
@@ -26,8 +58,74 @@ void SocketUdp::connect(const RemoteIPSockets& remotes)
 
 void SocketUdp::send(const ChatMessage& msg)
 {
+    sendToPeers(config.big_msg_size ? big_msg : msg);
+}
+
+void SocketUdp::sendToPeers(const ChatMessage& msg)
+{
+    if (peers.empty())
+        return;
+
+    INFO_LOG << "Sending message: " << (msg.size() < 100 ? msg : "BIG") << " (size = " << msg.size()
+             << ") on fd = " << fd << " to " << peers.size() << " peers";
+
+    send_tos.clear();
     for (const auto& p : peers)
-        send(msg, p.first);
+        send_tos.push_back(p.first);
+
+    // with GSO a chunk is a train of gso_size datagrams which the kernel cuts up, otherwise it is a single datagram
+    const auto chunk_size = offload ? gsoChunkSize(config.gso_size) : max_datagram_size;
+    send_iovecs.clear();
+    for (Size offset = 0; offset < msg.size() or send_iovecs.empty(); offset += chunk_size)
+        send_iovecs.push_back({const_cast<char*>(msg.data()) + offset, min(chunk_size, msg.size() - offset)});
+
+    // every peer gets a header per chunk, only the destination differs
+    send_headers.assign(send_tos.size() * send_iovecs.size(), mmsghdr{});
+    auto header = begin(send_headers);
+    auto peer = begin(peers);
+    for (auto i = 0u; i < send_tos.size(); ++i, ++peer)
+        for (auto& iov : send_iovecs)
+        {
+            auto& msg_hdr = (header++)->msg_hdr;
+            msg_hdr.msg_name = &send_tos[i];
+            msg_hdr.msg_namelen = peer->first.sizeofSockaddr();
+            msg_hdr.msg_iov = &iov;
+            msg_hdr.msg_iovlen = 1;
+        }
+
+    // datagrams are not worth queueing - a full send buffer drops the rest of the fan-out, a failing peer only its own
+    for (auto sent = 0u; sent < send_headers.size();)
+    {
+        const auto result = sendmmsg(fd, &send_headers[sent], send_headers.size() - sent, ignore_flags);
+        if (result >= 0)
+            sent += result;
+        else if (errno == EAGAIN or errno == EWOULDBLOCK)
+        {
+            WARN_LOG << "Send buffer of fd = " << fd << " is full, dropped " << send_headers.size() - sent
+                     << " datagrams";
+            return;
+        }
+        else
+        {
+            WARN_LOG << "Sending datagram " << sent << " on fd = " << fd << " failed: " << strerror(errno);
+            ++sent;
+        }
+    }
+}
+
+void SocketUdp::configure(FD fd)
+{
+    Socket::configure(fd);
+    if (config.threads > 1)
+        configureReusePort(fd);
+
+    if (offload)
+    {
+        configureUdpSegment(fd, config.gso_size);
+        configureUdpGro(fd);
+    }
+    else if (config.gso_size)
+        WARN_LOG << "UDP-Lite does not support segmentation offload, ignoring -gso on fd = " << fd;
 }
 
 namespace
@@ -40,17 +138,51 @@ namespace
 
 void SocketUdp::handleMessage(FD fd)
 {
-    sockaddr_storage from_storage{};
-    socklen_t from_len = sizeof(from_storage);
+    for (auto i = 0; i < receive_batch_size; ++i)
+    {
+        auto& header = receive_headers[i].msg_hdr;
+        header = {};
+        header.msg_name = &receive_froms[i];
+        header.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_iov = &receive_iovecs[i];
+        header.msg_iovlen = 1;
+        header.msg_control = receive_controls[i].data();
+        header.msg_controllen = sizeof(Control);
+    }
 
-    auto& msg_buffer = getBuffer(fd);
+    const auto count =
+        checkedReceive(recvmmsg(fd, receive_headers.data(), receive_batch_size, MSG_DONTWAIT, no_timeout));
+    DEBUG_LOG << "Received " << count << " datagrams on fd = " << fd;
 
-    msg_buffer[checkedReceive(
-        recvfrom(fd, msg_buffer.data(), msg_buffer.size(), ignore_flags, asSockaddrPtr(from_storage), &from_len))] = 0;
+    for (auto i = 0; i < count; ++i)
+        handleDatagrams(*receive_buffers[i], receive_headers[i].msg_len, receive_headers[i].msg_hdr, receive_froms[i]);
+}
+
+void SocketUdp::handleDatagrams(const IOBuffer& buffer, Size length, msghdr& header, const RemoteIPSocket& remote)
+{
+    // GRO coalesces datagrams of one flow into a single buffer and reports where to cut it
+    auto segment_size = length;
+    for (auto cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg))
+        if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO)
+        {
+            int gro_size{};
+            memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+            segment_size = gro_size;
+        }
 
-    const RemoteIPSocket remote = from_storage;
-    const ChatMessage msg{msg_buffer.data()};
-    INFO_LOG << "Received message: " << msg << " (size = " << msg.size() << ") from " << remote;
+    Size offset = 0;
+    do
+    {
+        const auto size = min(segment_size, length - offset);
+        handleDatagram(ChatMessage{buffer.data() + offset, size}, remote);
+        offset += segment_size;
+    } while (offset < length);
+}
+
+void SocketUdp::handleDatagram(const ChatMessage& msg, const RemoteIPSocket& remote)
+{
+    INFO_LOG << "Received message: " << (msg.size() < 100 ? msg : "BIG") << " (size = " << msg.size() << ") from "
+             << remote;
 
     if (msg == quit_msg)
         return handleGracefulShutdown(remote);
@@ -99,13 +231,13 @@ void SocketUdp::remove(const RemoteIPSocket& remote)
     DEBUG_LOG << "Removed peer = " << remote;
 }
 
-ScheduledTaskPtr SocketUdp::schedulePing(const RemoteIPSocket& remote)
+SocketUdp::TimerPtr SocketUdp::schedulePing(const RemoteIPSocket& remote)
 {
     return task_scheduler.schedule(
-        [=, this] { send(keep_alive_msg, remote); }, keep_alive_period, Repetitions{keep_alive_probes});
+        [=, this] { send(keep_alive_msg, remote); }, keep_alive_period, TimerWheel::Repetitions{keep_alive_probes});
 }
 
-ScheduledTaskPtr SocketUdp::scheduleCommLost(const RemoteIPSocket& remote)
+SocketUdp::TimerPtr SocketUdp::scheduleCommLost(const RemoteIPSocket& remote)
 {
     return task_scheduler.schedule([=, this] { handleCommLost(remote); }, keep_alive_period * (keep_alive_probes + 1));
 }
@@ -1,38 +1,59 @@
 #pragma once
 
-#include <tools/TaskScheduler.hpp>
 #include "Socket.hpp"
+#include "TimerWheel.hpp"
+
+struct NetworkConfiguration;
 
 class SocketUdp : public Socket
 {
 public:
-    SocketUdp(const LocalIPSockets&, TaskScheduler&, Protocol = default_protocol);
+    SocketUdp(const NetworkConfiguration&, TimerWheel&, Protocol = default_protocol);
     ~SocketUdp();
 
     void connect(const RemoteIPSockets&) override;
     void send(const ChatMessage&) override;
 
 private:
+    void configure(FD) override;
     void handleMessage(FD) override;
 
+    void sendToPeers(const ChatMessage&);
     void send(const ChatMessage&, const RemoteIPSocket&);
+    void handleDatagrams(const IOBuffer&, Size length, msghdr&, const RemoteIPSocket&);
+    void handleDatagram(const ChatMessage&, const RemoteIPSocket&);
     void handleCommUp(const RemoteIPSocket&);
     void handleGracefulShutdown(const RemoteIPSocket&);
     void handleCommLost(const RemoteIPSocket&);
     void remove(const RemoteIPSocket&);
 
-    ScheduledTaskPtr schedulePing(const RemoteIPSocket&);
-    ScheduledTaskPtr scheduleCommLost(const RemoteIPSocket&);
+    using TimerPtr = TimerWheel::TimerPtr;
+    TimerPtr schedulePing(const RemoteIPSocket&);
+    TimerPtr scheduleCommLost(const RemoteIPSocket&);
     void resetTasks(const RemoteIPSocket&);
     void disableTasks(const RemoteIPSocket&);
 
     struct Peer
     {
-        ScheduledTaskPtr ping_task;
-        ScheduledTaskPtr comm_lost_task;
+        TimerPtr ping_task;
+        TimerPtr comm_lost_task;
     };
     using Peers = std::map<RemoteIPSocket, Peer>;
     Peers peers;
 
+    // recvmmsg fills one pool buffer per datagram (or per GRO train), sendmmsg fans out one header per peer and chunk
+    using Control = std::array<char, CMSG_SPACE(sizeof(int))>;
+    std::vector<BufferPtr> receive_buffers;
+    std::vector<iovec> receive_iovecs;
+    std::vector<Control> receive_controls;
+    std::vector<sockaddr_storage> receive_froms;
+    std::vector<mmsghdr> receive_headers;
+    std::vector<sockaddr_storage> send_tos;
+    std::vector<iovec> send_iovecs;
+    std::vector<mmsghdr> send_headers;
+
     IP local;
+    const NetworkConfiguration& config;
+    bool offload = false;
+    ChatMessage big_msg;
 };
@@ -6,7 +6,7 @@
 
 using namespace std;
 
-SocketUnix::SocketUnix(TaskScheduler& ts)
+SocketUnix::SocketUnix(TimerWheel& ts)
     : Socket(LocalIPSockets{}, ts, SOCK_DGRAM, default_protocol, AF_UNIX)
 {
     SocketUnix::configure(fd);
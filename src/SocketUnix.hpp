@@ -8,7 +8,7 @@ using Path = std::string;
 class SocketUnix : public Socket
 {
 public:
-    SocketUnix(TaskScheduler&);
+    SocketUnix(TimerWheel&);
     ~SocketUnix();
 
     void connect(const RemoteIPSockets&) override;
@@ -28,7 +28,7 @@ namespace
     SigActionSignature(parentDied) { throw runtime_error{"Oh no, my parent is dead ;("}; }
 }
 
-SocketUnixForked::SocketUnixForked(TaskScheduler& ts)
+SocketUnixForked::SocketUnixForked(TimerWheel& ts)
     : Socket(LocalIPSockets{}, ts, SOCK_DGRAM, protocol, AF_UNIX, DeferCreation{true})
 {
     createMessageQueues();
@@ -37,6 +37,9 @@ SocketUnixForked::SocketUnixForked(TaskScheduler& ts)
     createNamedSemaphore();
     createUnnamedSemaphore();
     fork(createSocketPair(), createPipe(), createNamedPipe());
+    // the epoll instance created before fork is shared by both processes - each of them needs its own
+    epoll = Epoll{};
+    watch(fd);
     configure(fd);
     DEBUG_LOG << "Configured fd = " << fd;
 }
@@ -66,9 +69,9 @@ void SocketUnixForked::send(const ChatMessage& msg)
     postUnnamedSemaphore();
 }
 
-void SocketUnixForked::receive()
+void SocketUnixForked::receive(Timeout timeout)
 {
-    Socket::receive();
+    Socket::receive(timeout);
 
     readPosixSharedMemory();
     readSysVSharedMemory();
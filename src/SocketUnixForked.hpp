@@ -9,11 +9,11 @@ class SocketUnixForked : public Socket
 public:
     using Semaphore = sem_t;
 
-    SocketUnixForked(TaskScheduler&);
+    SocketUnixForked(TimerWheel&);
     ~SocketUnixForked();
 
     void send(const ChatMessage&) override;
-    void receive() override;
+    void receive(Timeout) override;
 
 private:
     using FileDescriptorPair = std::pair<FileDescriptor, FileDescriptor>;
@@ -1,6 +1,8 @@
 #include "StartTask.hpp"
+#include <pthread.h>
 #include <tools/CountTime.hpp>
 #include <tools/ThreadSafeLogger.hpp>
+#include "SocketErrorChecks.hpp"
 
 using namespace std;
 using namespace chrono;
@@ -17,3 +19,13 @@ void startTask(Name name, Delay delay)
 
     DEBUG_LOG << "Starting task";
 }
+
+void pinToCore(Size core)
+{
+    core %= max(1u, thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    checkSetaffinity(pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus));
+    DEBUG_LOG << "Pinned to core " << core;
+}
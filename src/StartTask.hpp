@@ -3,3 +3,4 @@
 #include "Typedefs.hpp"
 
 void startTask(Name, Delay = {});
+void pinToCore(Size);
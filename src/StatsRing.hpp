@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include "Typedefs.hpp"
+
+// Fixed-size ring of samples with one writer and any number of readers, none of which ever block. Every slot carries
+// a sequence number which is odd while the writer is inside, so readers simply drop a slot that changed underneath
+// them (seqlock). The oldest samples are overwritten once the ring is full.
+template <class T, Size capacity>
+class StatsRing
+{
+public:
+    using Index = u64;
+
+    void push(const T& value)
+    {
+        const auto index = next.load(std::memory_order_relaxed);
+        auto& slot = slots[index % capacity];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value = value;
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        next.store(index + 1, std::memory_order_release);
+    }
+
+    // appends everything from the given index on that is still in the ring and returns where to continue next time
+    Index read(Index from, std::vector<T>& out) const
+    {
+        const auto end = next.load(std::memory_order_acquire);
+        if (end > capacity and from < end - capacity)
+            from = end - capacity;
+
+        for (auto index = from; index < end; ++index)
+        {
+            const auto& slot = slots[index % capacity];
+            const auto before = slot.sequence.load(std::memory_order_acquire);
+            const T value = slot.value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto after = slot.sequence.load(std::memory_order_relaxed);
+            if (before == after and before == 2 * index + 2)
+                out.push_back(value);
+        }
+        return end;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<Index> sequence{};
+        T value{};
+    };
+
+    std::array<Slot, capacity> slots;
+    std::atomic<Index> next{};
+};
@@ -0,0 +1,35 @@
+#include "StreamSelector.hpp"
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+using namespace std;
+
+namespace
+{
+    // "key:payload" messages carry their own key, anything else is keyed by the whole message
+    string_view streamKey(const ChatMessage& msg)
+    {
+        const string_view view = msg;
+        return view.substr(0, view.find(':'));
+    }
+} // namespace
+
+StreamSelector createStreamSelector(StreamPolicy policy)
+{
+    switch (policy)
+    {
+        case StreamPolicy::RoundRobin: return [next = StreamId{}](const ChatMessage&) mutable { return next++; };
+        case StreamPolicy::Hash:
+            return [](const ChatMessage& msg) { return static_cast<StreamId>(hash<string_view>{}(streamKey(msg))); };
+        default:
+            return [](const ChatMessage& msg) {
+                // messages without a numeric key stay on stream 0, "12abc:..." is no more numeric than "abc:..."
+                StreamId stream{};
+                const auto key = streamKey(msg);
+                const auto key_end = key.data() + key.size();
+                const auto [parsed_end, error] = from_chars(key.data(), key_end, stream);
+                return error == errc{} and parsed_end == key_end ? stream : StreamId{};
+            };
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <functional>
+#include "StreamPolicy.hpp"
+#include "Typedefs.hpp"
+
+// Picks the outbound SCTP stream for a message. The result is wrapped to the stream count of each association.
+using StreamSelector = std::function<StreamId(const ChatMessage&)>;
+
+StreamSelector createStreamSelector(StreamPolicy);
@@ -0,0 +1,45 @@
+#include "TimerFd.hpp"
+#include <sys/timerfd.h>
+#include "SocketErrorChecks.hpp"
+
+using namespace std::chrono;
+
+namespace
+{
+    constexpr auto relative = 0;
+    constexpr auto ignore_old_value = nullptr;
+
+    template <class Time>
+    timespec toTimespec(Time time)
+    {
+        const auto secs = duration_cast<seconds>(time);
+        return {secs.count(), duration_cast<nanoseconds>(time - secs).count()};
+    }
+} // namespace
+
+TimerFd::TimerFd() : fd(checkedTimerfd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))) {}
+
+TimerFd::operator FD() const
+{
+    return fd;
+}
+
+void TimerFd::arm(Delay delay, Interval interval)
+{
+    // a zero it_value would disarm the timer instead of firing it right away
+    const auto value = std::max<nanoseconds>(delay, 1ns);
+    const itimerspec spec{toTimespec(interval), toTimespec(value)};
+    checkSettime(timerfd_settime(fd, relative, &spec, ignore_old_value));
+}
+
+void TimerFd::disarm()
+{
+    const itimerspec spec{};
+    checkSettime(timerfd_settime(fd, relative, &spec, ignore_old_value));
+}
+
+void TimerFd::clear()
+{
+    u64 ignore_expirations;
+    checkRead(read(fd, &ignore_expirations, sizeof(ignore_expirations)));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "FileDescriptor.hpp"
+
+class TimerFd
+{
+public:
+    using Interval = Delay;
+
+    TimerFd();
+
+    operator FD() const;
+
+    void arm(Delay, Interval = {});
+    void disarm();
+    void clear();
+
+private:
+    FileDescriptor fd;
+};
@@ -0,0 +1,163 @@
+#include "TimerWheel.hpp"
+#include <tools/ThreadSafeLogger.hpp>
+
+using namespace std;
+using namespace chrono;
+
+namespace
+{
+    using Tick = u64;
+    constexpr auto tick = 1ms;
+} // namespace
+
+TimerWheel::Timer::Timer(TimerWheel& wheel, Task task, Delay period, Repetitions repetitions)
+    : wheel(wheel), task(move(task)), period(period), repetitions(repetitions), remaining(repetitions)
+{
+}
+
+void TimerWheel::Timer::reset()
+{
+    lock_guard<mutex> lg{wheel.mtx};
+    if (not slot)
+        return;
+    remaining = repetitions;
+    expiry = wheel.expiryTick(Clock::now() + period);
+    wheel.insert(*this, *slot);
+}
+
+void TimerWheel::Timer::disable()
+{
+    lock_guard<mutex> lg{wheel.mtx};
+    if (slot)
+        wheel.remove(*this);
+}
+
+TimerWheel::TimerWheel() : start(Clock::now()) {}
+
+TimerWheel::TimerPtr TimerWheel::schedule(Task task, Delay delay, Repetitions repetitions)
+{
+    shared_ptr<Timer> timer{new Timer{*this, move(task), delay, repetitions}};
+    lock_guard<mutex> lg{mtx};
+    unscheduled.push_back(timer);
+    timer->position = prev(end(unscheduled));
+    timer->expiry = expiryTick(Clock::now() + delay);
+    insert(*timer, unscheduled);
+    ++timer_count;
+    return timer;
+}
+
+void TimerWheel::launch()
+{
+    Slot expired;
+    vector<Task> due_tasks;
+    {
+        lock_guard<mutex> lg{mtx};
+        advance(elapsedTicks(), expired);
+
+        // repeating timers go back onto the wheel before anything runs, so that their tasks may reset or disable them
+        for (auto it = begin(expired); it != end(expired);)
+        {
+            auto& timer = **it++;
+            due_tasks.push_back(timer.task);
+            if (--timer.remaining)
+            {
+                timer.expiry = current + max<Tick>(1, duration_cast<milliseconds>(timer.period) / tick);
+                insert(timer, expired);
+            }
+            else
+                remove(timer);
+        }
+    }
+
+    for (auto& task : due_tasks)
+        task();
+}
+
+optional<Delay> TimerWheel::timeUntilNext() const
+{
+    lock_guard<mutex> lg{mtx};
+    if (not timer_count)
+        return nullopt;
+
+    // a timer on a higher level is only known to expire no earlier than the moment its slot gets cascaded
+    auto next = numeric_limits<Tick>::max();
+    for (auto level = 0u; level < levels; ++level)
+    {
+        const auto level_current = current >> (slot_bits * level);
+        for (Tick i = 1; i <= slots_per_level; ++i)
+            if (not wheel[level][(level_current + i) % slots_per_level].empty())
+            {
+                next = min(next, (level_current + i) << (slot_bits * level));
+                break;
+            }
+    }
+
+    return max(Delay{}, duration_cast<Delay>(toTimePoint(next) - Clock::now()));
+}
+
+Tick TimerWheel::elapsedTicks() const
+{
+    return static_cast<Tick>(floor<milliseconds>(Clock::now() - start) / tick);
+}
+
+Tick TimerWheel::expiryTick(Clock::time_point time) const
+{
+    // rounded up, so that nothing fires early - and always at least one tick ahead, since the current one is done
+    const auto ticks = static_cast<Tick>(ceil<milliseconds>(time - start) / tick);
+    return max(ticks, current + 1);
+}
+
+TimerWheel::Clock::time_point TimerWheel::toTimePoint(Tick t) const
+{
+    return start + t * tick;
+}
+
+void TimerWheel::insert(Timer& timer, Slot& from)
+{
+    // timers beyond the top level wait in its furthest slot and get placed again when that one is cascaded
+    const auto placement = min(timer.expiry, current + levelSpan(levels) - 1);
+    const auto delta = placement - current;
+    auto level = 0u;
+    while (level < levels - 1 and delta >= levelSpan(level + 1))
+        ++level;
+
+    auto& slot = wheel[level][(placement >> (slot_bits * level)) % slots_per_level];
+    slot.splice(end(slot), from, timer.position);
+    timer.slot = &slot;
+}
+
+void TimerWheel::remove(Timer& timer)
+{
+    auto& slot = *timer.slot;
+    timer.slot = nullptr;
+    --timer_count;
+    slot.erase(timer.position);
+}
+
+void TimerWheel::advance(Tick target, Slot& expired)
+{
+    if (not timer_count)
+    {
+        current = max(current, target);
+        return;
+    }
+
+    while (current < target)
+    {
+        ++current;
+        for (auto level = 1u; level < levels and current % levelSpan(level) == 0; ++level)
+            cascade(level);
+
+        auto& slot = wheel[0][current % slots_per_level];
+        for (auto& timer : slot)
+            timer->slot = &expired;
+        expired.splice(end(expired), slot);
+    }
+}
+
+void TimerWheel::cascade(Size level)
+{
+    auto& slot = wheel[level][(current >> (slot_bits * level)) % slots_per_level];
+    while (not slot.empty())
+        insert(*slot.front(), slot);
+}
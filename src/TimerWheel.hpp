@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include "Typedefs.hpp"
+
+// Hierarchical timing wheel with a 1 ms tick. Scheduling, resetting and disabling a timer are O(1) - a timer is only
+// ever spliced between slot lists, which are cascaded down a level whenever the level below wraps around.
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<void()>;
+    using Repetitions = unsigned;
+
+    class Timer
+    {
+    public:
+        void reset();
+        void disable();
+
+    private:
+        friend class TimerWheel;
+        using Tick = u64;
+        using Slot = std::list<std::shared_ptr<Timer>>;
+
+        Timer(TimerWheel&, Task, Delay, Repetitions);
+
+        TimerWheel& wheel;
+        Task task;
+        Delay period;
+        Repetitions repetitions;
+        Repetitions remaining;
+        Tick expiry{};
+        Slot* slot = nullptr;
+        Slot::iterator position;
+    };
+    using TimerPtr = std::weak_ptr<Timer>;
+
+    TimerWheel();
+
+    TimerPtr schedule(Task, Delay, Repetitions = 1);
+    void launch();
+    std::optional<Delay> timeUntilNext() const;
+
+private:
+    using Tick = Timer::Tick;
+    using Slot = Timer::Slot;
+    static constexpr auto slot_bits = 6;
+    static constexpr auto slots_per_level = 1 << slot_bits;
+    static constexpr auto levels = 4;
+    using Level = std::array<Slot, slots_per_level>;
+
+    static constexpr Tick levelSpan(Size level) { return Tick{1} << (slot_bits * level); }
+
+    Tick elapsedTicks() const;
+    Tick expiryTick(Clock::time_point) const;
+    Clock::time_point toTimePoint(Tick) const;
+    void insert(Timer&, Slot& from);
+    void remove(Timer&);
+    void advance(Tick target, Slot& expired);
+    void cascade(Size level);
+
+    const Clock::time_point start;
+    Tick current{};
+    std::array<Level, levels> wheel;
+    Slot unscheduled;
+    Size timer_count{};
+    mutable std::mutex mtx;
+};
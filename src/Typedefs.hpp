@@ -1,11 +1,15 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include "IPSocket.hpp"
 
 using ChatMessage = std::string;
+using SharedChatMessage = std::shared_ptr<const ChatMessage>;
 using Delay = std::chrono::milliseconds;
 using AssocId = sctp_assoc_t;
+using StreamId = u16;
+using ControlBuffer = std::vector<char>;
 using FD = int;
 using FDs = std::vector<FD>;
 using SocketParam = int;
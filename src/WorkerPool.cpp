@@ -0,0 +1,114 @@
+#include "WorkerPool.hpp"
+#include <tools/ThreadSafeLogger.hpp>
+
+using namespace std;
+
+WorkerPool::WorkerPool(Size worker_count)
+{
+    for (auto i = 0u; i < worker_count; ++i)
+        workers.push_back(make_unique<Worker>());
+    for (auto i = 0u; i < worker_count; ++i)
+        threads.emplace_back(&WorkerPool::run, this, i);
+    DEBUG_LOG << "Started " << worker_count << " workers";
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> lock{mtx};
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void WorkerPool::dispatch(Affinity affinity, Task task)
+{
+    auto& worker = *workers[affinity % workers.size()];
+    {
+        lock_guard<mutex> lock{worker.mtx};
+        worker.queue.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> lock{mtx};
+        ++queued;
+        ++unfinished;
+    }
+    work_available.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    unique_lock<mutex> lock{mtx};
+    all_done.wait(lock, [this] { return unfinished == 0; });
+    if (first_exception)
+        rethrow_exception(exchange(first_exception, nullptr));
+}
+
+void WorkerPool::run(Size index)
+{
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock{mtx};
+            work_available.wait(lock, [this] { return stopping or queued; });
+            if (stopping)
+                return;
+            --queued;
+        }
+
+        // every decrement of queued stands for a task that had been queued before it, so one is bound to turn up
+        Task task;
+        while (not pop(index, task) and not steal(index, task))
+            this_thread::yield();
+
+        try
+        {
+            task();
+            finish(nullptr);
+        }
+        catch (...)
+        {
+            finish(current_exception());
+        }
+    }
+}
+
+bool WorkerPool::pop(Size index, Task& task)
+{
+    auto& worker = *workers[index];
+    lock_guard<mutex> lock{worker.mtx};
+    if (worker.queue.empty())
+        return false;
+    task = move(worker.queue.front());
+    worker.queue.pop_front();
+    return true;
+}
+
+bool WorkerPool::steal(Size thief, Task& task)
+{
+    for (auto i = 1u; i < workers.size(); ++i)
+    {
+        auto& victim = *workers[(thief + i) % workers.size()];
+        lock_guard<mutex> lock{victim.mtx};
+        if (not victim.queue.empty())
+        {
+            task = move(victim.queue.back());
+            victim.queue.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::finish(exception_ptr exception)
+{
+    {
+        lock_guard<mutex> lock{mtx};
+        if (exception and not first_exception)
+            first_exception = exception;
+        --unfinished;
+    }
+    all_done.notify_all();
+}
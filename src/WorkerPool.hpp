@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+#include "Typedefs.hpp"
+
+// Fixed set of threads with one queue each. Tasks with the same affinity key land on the same worker; idle workers
+// steal from the back of the others' queues.
+class WorkerPool
+{
+public:
+    using Task = std::function<void()>;
+    using Affinity = Size;
+
+    explicit WorkerPool(Size worker_count = std::max(1u, std::thread::hardware_concurrency()));
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void dispatch(Affinity, Task);
+    void wait();
+
+private:
+    struct Worker
+    {
+        std::deque<Task> queue;
+        std::mutex mtx;
+    };
+
+    void run(Size index);
+    bool pop(Size index, Task&);
+    bool steal(Size thief, Task&);
+    void finish(std::exception_ptr);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mtx;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    Size queued{};
+    Size unfinished{};
+    std::exception_ptr first_exception;
+    bool stopping = false;
+};
@@ -11,12 +11,13 @@ using namespace RangeOperators;
 
 namespace
 {
+    constexpr auto localhost = "127.0.0.1";
+    constexpr auto s1_port = 36412;
+    constexpr auto x2_port = 36422;
+
     void runPredefinedConfig(const NetworkConfiguration& config, AsyncTasks& tasks)
     {
-        constexpr auto localhost = "127.0.0.1";
         // constexpr auto nat = "10.0.2.15";
-        constexpr auto s1_port = 36412;
-        constexpr auto x2_port = 36422;
 
         auto mme = config;
         mme.locals += IPSocket{localhost, s1_port};
@@ -38,9 +39,37 @@ namespace
         tasks += asyncTask(networkTask, NetworkTaskParams{enb2, "eNB2", Delay{200ms}, Lifetime{13s}});
     }
 
+    void runBenchmark(const NetworkConfiguration& config, AsyncTasks& tasks)
+    {
+        // one server with -bench associations from as many chatty clients, run with and without -no_peeloff and
+        // compare the fds and wakeups of the server's load reports
+        constexpr auto default_load_report_period = Delay{1s};
+        constexpr auto default_chatter_period = Delay{100ms};
+
+        auto server = config;
+        server.locals += IPSocket{localhost, s1_port};
+        if (not server.load_report_period.count())
+            server.load_report_period = default_load_report_period;
+        server.chatter_period = {};
+        tasks += asyncTask(networkTask, NetworkTaskParams{server, "Server"});
+
+        for (Size i = 0; i < config.bench_associations; ++i)
+        {
+            auto client = config;
+            client.locals += IPSocket{localhost, static_cast<Port>(x2_port + i)};
+            client.remotes += server.locals.front();
+            client.load_report_period = {};
+            if (not client.chatter_period.count())
+                client.chatter_period = default_chatter_period;
+            tasks += asyncTask(networkTask, NetworkTaskParams{client, "Client" + to_string(i), Delay{100ms}});
+        }
+    }
+
     void runNetwork(const NetworkConfiguration& config, AsyncTasks& tasks)
     {
-        if (not config.locals.empty() or isUnix(config.protocol))
+        if (config.bench_associations)
+            runBenchmark(config, tasks);
+        else if (not config.locals.empty() or isUnix(config.protocol))
             tasks += asyncTask(networkTask, NetworkTaskParams{config});
         else
             runPredefinedConfig(config, tasks);